@@ -0,0 +1,134 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#ifndef LADSPAPP_BENCH_H
+#define LADSPAPP_BENCH_H
+
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <vector>
+
+//! A minimal microbenchmark harness, only used by the benchmarks
+namespace bench
+{
+
+//! keeps the compiler from optimizing away the results in @a p
+inline void clobber(const void* p)
+{
+	asm volatile("" : : "g"(p) : "memory");
+}
+
+//! Runs @a f repeatedly for at least @a min_seconds,
+//! returns the best time of one call in nanoseconds
+template<class F>
+double measure(F f, double min_seconds = 0.2)
+{
+	typedef std::chrono::steady_clock clock;
+	double best = 1e300, total = 0;
+	f(); // warm up
+	do
+	{
+		const clock::time_point start = clock::now();
+		f();
+		const double ns = std::chrono::duration<double, std::nano>(
+			clock::now() - start).count();
+		best = (ns < best) ? ns : best;
+		total += ns;
+	} while(total < min_seconds * 1e9);
+	return best;
+}
+
+//! Prints the times of a naive and an optimized version
+inline void report(const char* name, double naive_ns, double fast_ns,
+	const char* naive_label = "naive")
+{
+	std::printf("%-32s %s: %10.0f ns  ladspa++: %10.0f ns  "
+		"speedup: %5.2fx\n", name, naive_label, naive_ns, fast_ns,
+		naive_ns / fast_ns);
+}
+
+//! Collects the results of a benchmark run, and stores them as JSON
+class suite
+{
+	struct result
+	{
+		std::string name;
+		double naive_ns, fast_ns;
+	};
+	std::vector<result> results;
+	const char* naive_label;
+
+	void write(std::FILE* f, const char* commit) const
+	{
+		std::fprintf(f, "{\"commit\": \"%s\", \"time\": %ld, "
+			"\"results\": [", commit, (long)std::time(nullptr));
+		for(std::size_t i = 0; i < results.size(); ++i)
+			std::fprintf(f, "%s{\"name\": \"%s\", \"naive_ns\": %.1f, "
+				"\"ladspapp_ns\": %.1f}", i ? ", " : "",
+				results[i].name.c_str(), results[i].naive_ns,
+				results[i].fast_ns);
+		std::fprintf(f, "]}\n");
+	}
+
+public:
+	//! @param _naive_label what the naive versions are, when printing
+	suite(const char* _naive_label = "naive") : naive_label(_naive_label) {}
+
+	//! Stores and prints a result
+	void add(const char* name, double naive_ns, double fast_ns)
+	{
+		results.push_back({ name, naive_ns, fast_ns });
+		report(name, naive_ns, fast_ns, naive_label);
+	}
+
+	//! The highest ratio of optimized to naive time
+	double worst_ratio() const
+	{
+		double res = 0;
+		for(const result& r : results)
+			res = (r.fast_ns / r.naive_ns > res)
+				? r.fast_ns / r.naive_ns : res;
+		return res;
+	}
+
+	//! Writes the results to @a path, and appends them as one line to
+	//! @a history_path, if given
+	bool write_json(const char* path, const char* history_path,
+		const char* commit) const
+	{
+		std::FILE* f = std::fopen(path, "w");
+		if(!f)
+			return false;
+		write(f, commit);
+		bool ok = std::fclose(f) == 0;
+		if(history_path && (f = std::fopen(history_path, "a")))
+		{
+			write(f, commit);
+			ok = std::fclose(f) == 0 && ok;
+		}
+		return ok;
+	}
+};
+
+}
+
+#endif // LADSPAPP_BENCH_H
@@ -0,0 +1,120 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#include <cstdlib>
+#include <vector>
+
+#include "ladspa++/biquad.h"
+#include "bench.h"
+
+using namespace ladspa;
+
+static constexpr std::size_t block = 1024;
+static constexpr std::size_t bands = 8;
+static constexpr double rate = 48000;
+
+//! what most plugins do: one direct form loop per section
+template<std::size_t Sections>
+static void naive_cascade(biquad (&filters)[Sections],
+	const data* in, data* out, std::size_t n)
+{
+	for(std::size_t i = 0; i < n; ++i)
+	{
+		data x = in[i];
+		for(biquad& f : filters)
+			x = f.tick(x);
+		out[i] = x;
+	}
+}
+
+template<std::size_t Sections>
+static void bench_cascade(const char* name, const data* in, data* out)
+{
+	biquad naive[Sections];
+	biquad_cascade<Sections> cascade;
+	for(std::size_t s = 0; s < Sections; ++s)
+	{
+		const biquad_coeffs c = biquad_coeffs::peaking(
+			100 * (s + 1), 1, 3, rate);
+		naive[s].set(c);
+		cascade.set(s, c);
+	}
+	bench::report(name,
+		bench::measure([&]() {
+			naive_cascade(naive, in, out, block);
+			bench::clobber(out); }),
+		bench::measure([&]() {
+			cascade.process(in, out, block);
+			bench::clobber(out); }));
+}
+
+int main()
+{
+	std::vector<data> in(block), out(block);
+	for(data& x : in)
+		x = std::rand() / (data)RAND_MAX * 2 - 1;
+
+	/*
+	 * cascade on one channel
+	 */
+	bench_cascade<1>("cascade, 1 section", in.data(), out.data());
+	bench_cascade<2>("cascade, 2 sections", in.data(), out.data());
+	bench_cascade<4>("cascade, 4 sections", in.data(), out.data());
+
+	/*
+	 * one filter per channel
+	 */
+	std::vector<std::vector<data>> ins(bands, in), outs(bands, out);
+	const data* in_ptrs[bands];
+	data* out_ptrs[bands];
+	biquad naive_bands[bands];
+	biquad_bank<bands> bank;
+	for(std::size_t b = 0; b < bands; ++b)
+	{
+		const biquad_coeffs c = biquad_coeffs::bandpass(
+			100 * (b + 1), 2, rate);
+		naive_bands[b].set(c);
+		bank.set(b, c);
+		in_ptrs[b] = ins[b].data();
+		out_ptrs[b] = outs[b].data();
+	}
+	bench::report("bank, 8 channels",
+		bench::measure([&]() {
+			for(std::size_t b = 0; b < bands; ++b)
+				naive_bands[b].process(in_ptrs[b], out_ptrs[b], block);
+			bench::clobber(out_ptrs); }),
+		bench::measure([&]() {
+			bank.process(in_ptrs, out_ptrs, block);
+			bench::clobber(out_ptrs); }));
+
+	/*
+	 * filter bank on one input
+	 */
+	bench::report("bank, 8 bands of one input",
+		bench::measure([&]() {
+			for(std::size_t b = 0; b < bands; ++b)
+				naive_bands[b].process(in.data(), out_ptrs[b], block);
+			bench::clobber(out_ptrs); }),
+		bench::measure([&]() {
+			bank.process(in.data(), out_ptrs, block);
+			bench::clobber(out_ptrs); }));
+
+	return EXIT_SUCCESS;
+}
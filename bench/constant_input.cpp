@@ -0,0 +1,122 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include "ladspa++.h"
+#include "ladspa++/biquad.h"
+#include "bench.h"
+
+using namespace ladspa;
+
+static constexpr std::size_t block = 1024;
+static constexpr double rate = 48000;
+
+//! a low pass with an audio rate cutoff input, as most plugins write it:
+//! the coefficients are computed for each sample
+static void naive_filter(biquad& f, const data* in, const data* cutoff,
+	data* out, std::size_t n)
+{
+	for(std::size_t i = 0; i < n; ++i)
+	{
+		f.set(biquad_coeffs::lowpass(cutoff[i], 0.7, rate));
+		out[i] = f.tick(in[i]);
+	}
+}
+
+//! the same filter, with a scalar kernel for constant cutoffs
+static void dispatched_filter(biquad& f, const data* in, const data* cutoff,
+	data* out, std::size_t n)
+{
+	data value;
+	if(is_constant(const_buffer(cutoff, n), value))
+	{
+		f.set(biquad_coeffs::lowpass(value, 0.7, rate));
+		f.process(in, out, n);
+	}
+	else
+		naive_filter(f, in, cutoff, out, n);
+}
+
+//! a check which stops at the first differing sample
+static bool naive_is_constant(const data* x, std::size_t n)
+{
+	for(std::size_t i = 1; i < n; ++i)
+		if(x[i] != x[0])
+			return false;
+	return true;
+}
+
+int main()
+{
+	std::vector<data> in(block), out(block),
+		unpatched(block, 1000), lfo(block);
+	for(data& x : in)
+		x = std::rand() / (data)RAND_MAX * 2 - 1;
+	for(std::size_t i = 0; i < block; ++i)
+		lfo[i] = 1000 + 500 * std::sin(i * 0.01);
+
+	biquad f;
+	bench::report("filter, unpatched cutoff",
+		bench::measure([&]() {
+			naive_filter(f, in.data(), unpatched.data(),
+				out.data(), block);
+			bench::clobber(out.data()); }),
+		bench::measure([&]() {
+			dispatched_filter(f, in.data(), unpatched.data(),
+				out.data(), block);
+			bench::clobber(out.data()); }),
+		"per sample");
+	bench::report("filter, modulated cutoff",
+		bench::measure([&]() {
+			naive_filter(f, in.data(), lfo.data(), out.data(), block);
+			bench::clobber(out.data()); }),
+		bench::measure([&]() {
+			dispatched_filter(f, in.data(), lfo.data(),
+				out.data(), block);
+			bench::clobber(out.data()); }),
+		"per sample");
+
+	/*
+	 * cost of the check alone
+	 */
+	bool res = false;
+	data value;
+	bench::report("check, constant input",
+		bench::measure([&]() {
+			res = naive_is_constant(unpatched.data(), block);
+			bench::clobber(&res); }),
+		bench::measure([&]() {
+			res = is_constant(const_buffer(unpatched.data(), block),
+				value);
+			bench::clobber(&res); }));
+	bench::report("check, constant input, stride 16",
+		bench::measure([&]() {
+			res = naive_is_constant(unpatched.data(), block);
+			bench::clobber(&res); }),
+		bench::measure([&]() {
+			res = is_constant(const_buffer(unpatched.data(), block),
+				value, 16);
+			bench::clobber(&res); }));
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,81 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include "ladspa++/convolver.h"
+#include "bench.h"
+
+using namespace ladspa;
+
+static constexpr std::size_t block = 1024;
+static constexpr std::size_t length = 24000; // half a second at 48 kHz
+
+//! direct form FIR over a linear history buffer
+class naive_fir
+{
+	std::vector<data> h, history;
+public:
+	naive_fir(const data* ir, std::size_t n) :
+		h(ir, ir + n), history(n - 1 + block, 0) {}
+
+	void process(const data* in, data* out, std::size_t n)
+	{
+		data* const x = &history[h.size() - 1];
+		std::copy(in, in + n, x);
+		std::fill(out, out + n, 0);
+		for(std::size_t k = 0; k < h.size(); ++k)
+		for(std::size_t i = 0; i < n; ++i)
+			out[i] += h[k] * (x - k)[i];
+		std::copy(history.begin() + n, history.end(), history.begin());
+	}
+};
+
+int main()
+{
+	std::vector<data> ir(length), in(block), out(block);
+	for(data& x : ir)
+		x = std::rand() / (data)RAND_MAX * 2 - 1;
+	for(data& x : in)
+		x = std::rand() / (data)RAND_MAX * 2 - 1;
+
+	naive_fir fir(ir.data(), length);
+	const double naive_ns = bench::measure([&]() {
+		fir.process(in.data(), out.data(), block);
+		bench::clobber(out.data()); });
+
+	for(std::size_t partition : { 64, 256, 1024 })
+	{
+		convolver conv;
+		conv.prepare(std::make_shared<const ir_spectra>(ir.data(), length,
+			partition));
+		char name[64];
+		std::snprintf(name, sizeof(name), "convolution, partitions of %d",
+			(int)partition);
+		bench::report(name, naive_ns, bench::measure([&]() {
+			conv.process(in.data(), out.data(), block);
+			bench::clobber(out.data()); }));
+	}
+
+	return EXIT_SUCCESS;
+}
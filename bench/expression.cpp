@@ -0,0 +1,73 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include "ladspa++/expression.h"
+#include "bench.h"
+
+using namespace ladspa;
+
+static constexpr std::size_t block = 4096;
+
+int main()
+{
+	std::vector<data> a(block), b(block), out(block), tmp(block);
+	for(std::size_t i = 0; i < block; ++i)
+	{
+		a[i] = std::rand() / (data)RAND_MAX * 2 - 1;
+		b[i] = std::rand() / (data)RAND_MAX * 2 - 1;
+	}
+	const data g1 = 0.5f, g2 = 0.25f, mix = 0.3f;
+	const_buffer in_a(a.data(), block), in_b(b.data(), block);
+	buffer out_buffer(out.data(), block);
+
+	// what array libraries without expression templates do:
+	// one pass and one temporary per operator
+	bench::report("a * g1 + b * g2",
+		bench::measure([&]() {
+			for(std::size_t i = 0; i < block; ++i)
+				out[i] = a[i] * g1;
+			for(std::size_t i = 0; i < block; ++i)
+				tmp[i] = b[i] * g2;
+			for(std::size_t i = 0; i < block; ++i)
+				out[i] += tmp[i];
+			bench::clobber(out.data()); }),
+		bench::measure([&]() {
+			out_buffer = in_a * g1 + in_b * g2;
+			bench::clobber(out.data()); }));
+
+	bench::report("out += tanh(a) * mix",
+		bench::measure([&]() {
+			for(std::size_t i = 0; i < block; ++i)
+				tmp[i] = std::tanh(a[i]);
+			for(std::size_t i = 0; i < block; ++i)
+				tmp[i] *= mix;
+			for(std::size_t i = 0; i < block; ++i)
+				out[i] += tmp[i];
+			bench::clobber(out.data()); }),
+		bench::measure([&]() {
+			out_buffer += tanh(in_a) * mix;
+			bench::clobber(out.data()); }));
+
+	return EXIT_SUCCESS;
+}
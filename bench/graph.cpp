@@ -0,0 +1,168 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "ladspa++.h"
+#include "ladspa++/biquad.h"
+#include "ladspa++/graph.h"
+#include "bench.h"
+
+using namespace ladspa;
+
+//! one realtime block
+static constexpr sample_size_t block = 256;
+static constexpr sample_rate_t rate = 48000;
+//! nodes of each graph
+static constexpr std::size_t nodes = 256;
+
+//! a four band equalizer, as a typical node
+class equalizer
+{
+	biquad_cascade<4> cascade;
+
+public:
+	enum class port_names
+	{
+		in_1,
+		out_1,
+		size
+	};
+
+	static constexpr port_info_t port_info[] =
+	{
+		port_info_common::audio_input,
+		port_info_common::audio_output,
+		port_info_common::final_port
+	};
+
+	static constexpr info_t info =
+	{
+		4294, "equalizer", properties::hard_rt_capable,
+		"Equalizer", "", "", {}, strings::copyright::gpl3, nullptr
+	};
+
+	explicit equalizer(sample_rate_t sample_rate)
+	{
+		for(std::size_t s = 0; s < 4; ++s)
+			cascade.set(s, biquad_coeffs::peaking(
+				100 * (s + 1), 1, 3, sample_rate));
+	}
+
+	void run(port_array_t<port_names, port_info>& ports)
+	{
+		const_buffer in = ports.get<port_names::in_1>();
+		buffer out = ports.get<port_names::out_1>();
+		cascade.process(in, out);
+	}
+};
+
+constexpr port_info_t equalizer::port_info[];
+constexpr info_t equalizer::info;
+
+enum class shape
+{
+	wide, //!< all nodes read the input
+	deep, //!< one chain
+	chains //!< 16 chains of 16 nodes
+};
+
+//! builds a graph of @a s shape, and returns the time of one cycle
+static double measure(shape s, unsigned threads, const char* name)
+{
+	const LADSPA_Descriptor* d
+		= collection<equalizer>::get_ladspa_descriptor(0);
+	graph g(rate, block, threads);
+	const std::size_t in = g.add_input();
+	std::vector<graph::node_id> ids;
+	for(std::size_t i = 0; i < nodes; ++i)
+		ids.push_back(g.add(d));
+
+	constexpr std::size_t width = 16;
+	for(std::size_t i = 0; i < nodes; ++i)
+	switch(s)
+	{
+		case shape::wide:
+			g.connect_input(in, ids[i], 0);
+			g.add_output(ids[i], 1);
+			break;
+		case shape::deep:
+			if(i)
+				g.connect(ids[i - 1], 1, ids[i], 0);
+			else
+				g.connect_input(in, ids[i], 0);
+			break;
+		case shape::chains:
+			if(i < width)
+				g.connect_input(in, ids[i], 0);
+			else
+				g.connect(ids[i - width], 1, ids[i], 0);
+			break;
+	}
+	if(s != shape::wide)
+		g.add_output(ids.back(), 1);
+	if(!g.compile())
+	{
+		std::fprintf(stderr, "could not compile the graph\n");
+		std::exit(EXIT_FAILURE);
+	}
+
+	for(sample_size_t i = 0; i < block; ++i)
+		g.input(in)[i] = std::rand() / (data)RAND_MAX * 2 - 1;
+	const double res = bench::measure([&]() {
+		g.run(block);
+		bench::clobber(g.output(0)); });
+	std::printf("  %-10s %u thread(s): %zu pooled buffers, "
+		"%llu of %llu cycles late, worst %.0f ns\n", name, threads,
+		g.pooled_buffers(),
+		(unsigned long long)g.stats().deadline_misses,
+		(unsigned long long)g.stats().cycles, g.stats().worst_ns);
+	return res;
+}
+
+int main()
+{
+	const unsigned threads = std::thread::hardware_concurrency() > 1
+		? std::thread::hardware_concurrency() : 2;
+	std::printf("%zu nodes, %u samples per cycle, deadline %.0f ns\n",
+		nodes, (unsigned)block, block * 1e9 / rate);
+
+	const struct { shape s; const char* name; } shapes[] =
+	{
+		{ shape::wide, "wide" },
+		{ shape::deep, "deep" },
+		{ shape::chains, "chains" }
+	};
+	for(const auto& s : shapes)
+	{
+		const double serial = measure(s.s, 1, s.name);
+		const double parallel = measure(s.s, threads, s.name);
+		char name[64];
+		std::snprintf(name, sizeof(name), "%s graph, %u threads",
+			s.name, threads);
+		bench::report(name, serial, parallel, "serial");
+	}
+
+	return EXIT_SUCCESS;
+}
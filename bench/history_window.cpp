@@ -0,0 +1,100 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#include <cstdlib>
+#include <vector>
+
+#include "ladspa++/history_window.h"
+#include "bench.h"
+
+using namespace ladspa;
+
+static constexpr std::size_t block = 256;
+static constexpr std::size_t taps = 32;
+
+//! what most plugins do: each sample goes into a ring buffer, and each
+//! tap reads it with a mask
+struct naive_fir
+{
+	data ring[64] = {};
+	std::size_t pos = 0;
+
+	void process(const data* h, const data* in, data* out, std::size_t n)
+	{
+		for(std::size_t i = 0; i < n; ++i)
+		{
+			ring[pos] = in[i];
+			data acc = 0;
+			for(std::size_t k = 0; k < taps; ++k)
+				acc += h[k] * ring[(pos - k) & 63];
+			out[i] = acc;
+			pos = (pos + 1) & 63;
+		}
+	}
+};
+
+//! the same filter, reading the host buffer through a history window
+struct window_fir
+{
+	history_window<taps> window;
+
+	void process(const data* h, const data* in, data* out, std::size_t n)
+	{
+		window.process(in, out, n,
+			[h](const data* x, data* y, std::size_t count) {
+			// the inner loop runs over the samples, so it is vectorized
+			for(std::size_t i = 0; i < count; ++i)
+				y[i] = h[0] * x[i];
+			for(std::size_t k = 1; k < taps; ++k)
+			for(std::size_t i = 0; i < count; ++i)
+				y[i] += h[k] * x[i - k];
+		});
+	}
+};
+
+int main()
+{
+	std::vector<data> in(block), out(block), h(taps);
+	for(data& x : in)
+		x = std::rand() / (data)RAND_MAX * 2 - 1;
+	for(std::size_t k = 0; k < taps; ++k)
+		h[k] = 1.0f / (k + 1);
+
+	naive_fir naive;
+	window_fir windowed;
+	bench::report("FIR, 32 taps",
+		bench::measure([&]() {
+			naive.process(h.data(), in.data(), out.data(), block);
+			bench::clobber(out.data()); }),
+		bench::measure([&]() {
+			windowed.process(h.data(), in.data(), out.data(), block);
+			bench::clobber(out.data()); }),
+		"ring buffer");
+	bench::report("FIR, 32 taps, in place",
+		bench::measure([&]() {
+			naive.process(h.data(), in.data(), in.data(), block);
+			bench::clobber(in.data()); }),
+		bench::measure([&]() {
+			windowed.process(h.data(), in.data(), in.data(), block);
+			bench::clobber(in.data()); }),
+		"ring buffer");
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,120 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include "ladspa++/meter.h"
+#include "bench.h"
+
+using namespace ladspa;
+
+static constexpr std::size_t block = 256;
+static constexpr std::size_t channels = 64;
+static constexpr double rate = 48000;
+
+//! what most plugins do: ballistics for each sample
+struct naive_peak
+{
+	data value = 0;
+	const data release = (data)std::exp(-1000 / (300 * rate));
+	void process(const data* in, std::size_t n)
+	{
+		for(std::size_t i = 0; i < n; ++i)
+			value = std::max(std::fabs(in[i]), value * release);
+	}
+};
+
+struct naive_rms
+{
+	data mean_square = 0;
+	const data coeff = 1 - (data)std::exp(-1000 / (300 * rate));
+	void process(const data* in, std::size_t n)
+	{
+		for(std::size_t i = 0; i < n; ++i)
+			mean_square += (in[i] * in[i] - mean_square) * coeff;
+	}
+};
+
+int main()
+{
+	std::vector<std::vector<data>> ins(channels, std::vector<data>(block));
+	for(std::vector<data>& in : ins)
+	for(data& x : in)
+		x = std::rand() / (data)RAND_MAX * 2 - 1;
+	std::vector<data> out(channels);
+
+	std::vector<naive_peak> naive_peaks(channels);
+	std::vector<naive_rms> naive_rmss(channels);
+	std::vector<peak_meter> peaks(channels, peak_meter(rate));
+	std::vector<rms_meter> rmss(channels, rms_meter(rate));
+	std::vector<peak_meter> decimated(channels, peak_meter(rate));
+	for(peak_meter& m : decimated)
+		m.set_decimation(4);
+
+	bench::report("peak, 64 channels",
+		bench::measure([&]() {
+			for(std::size_t c = 0; c < channels; ++c)
+			{
+				naive_peaks[c].process(ins[c].data(), block);
+				out[c] = naive_peaks[c].value;
+			}
+			bench::clobber(out.data()); }),
+		bench::measure([&]() {
+			for(std::size_t c = 0; c < channels; ++c)
+				peaks[c].process(const_buffer(ins[c].data(), block),
+					out[c]);
+			bench::clobber(out.data()); }));
+
+	bench::report("rms, 64 channels",
+		bench::measure([&]() {
+			for(std::size_t c = 0; c < channels; ++c)
+			{
+				naive_rmss[c].process(ins[c].data(), block);
+				out[c] = std::sqrt(naive_rmss[c].mean_square);
+			}
+			bench::clobber(out.data()); }),
+		bench::measure([&]() {
+			for(std::size_t c = 0; c < channels; ++c)
+				rmss[c].process(const_buffer(ins[c].data(), block),
+					out[c]);
+			bench::clobber(out.data()); }));
+
+	// every block is reduced, but the ballistics only run on every 4th,
+	// so time 4 blocks
+	bench::report("peak, 64 channels, decimated",
+		bench::measure([&]() {
+			for(std::size_t b = 0; b < 4; ++b)
+			for(std::size_t c = 0; c < channels; ++c)
+			{
+				naive_peaks[c].process(ins[c].data(), block);
+				out[c] = naive_peaks[c].value;
+			}
+			bench::clobber(out.data()); }) / 4,
+		bench::measure([&]() {
+			for(std::size_t b = 0; b < 4; ++b)
+			for(std::size_t c = 0; c < channels; ++c)
+				decimated[c].process(const_buffer(ins[c].data(), block),
+					out[c]);
+			bench::clobber(out.data()); }) / 4);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,142 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "ladspa++/oscillator.h"
+#include "bench.h"
+
+using namespace ladspa;
+
+static constexpr std::size_t block = 256;
+static constexpr double rate = 48000;
+static const double two_pi = 2 * 3.14159265358979323846;
+
+//! what most plugins do: one sin() per sample
+struct naive_sine
+{
+	double phase = 0;
+	void process(const data* freq, data* out, std::size_t n)
+	{
+		for(std::size_t i = 0; i < n; ++i)
+		{
+			out[i] = std::sin(two_pi * phase);
+			phase += freq[i] / rate;
+			phase -= std::floor(phase);
+		}
+	}
+};
+
+//! what most plugins do: a plain phase ramp, which aliases
+struct naive_saw
+{
+	double phase = 0;
+	void process(data freq, data* out, std::size_t n)
+	{
+		for(std::size_t i = 0; i < n; ++i)
+		{
+			out[i] = 2 * phase - 1;
+			phase += freq / rate;
+			phase -= std::floor(phase);
+		}
+	}
+};
+
+//! a band-limited saw without tables: all harmonics below the Nyquist
+//! frequency, summed up for each sample. Not what plugins do, but it
+//! sounds like the tables do.
+struct additive_saw
+{
+	double phase = 0;
+	void process(data freq, data* out, std::size_t n)
+	{
+		const unsigned harmonics = rate / 2 / freq;
+		for(std::size_t i = 0; i < n; ++i)
+		{
+			double x = 0;
+			for(unsigned k = 1; k <= harmonics; ++k)
+				x -= std::sin(two_pi * k * phase) / k;
+			out[i] = x * (2 / 3.14159265358979323846);
+			phase += freq / rate;
+			phase -= std::floor(phase);
+		}
+	}
+};
+
+//! prints the times, and how many voices one core can play in realtime
+static void report(const char* name, double naive_ns, double fast_ns,
+	const char* naive_label = "naive")
+{
+	const double block_ns = block / rate * 1e9;
+	bench::report(name, naive_ns, fast_ns, naive_label);
+	std::printf("%-32s voices per core: %s %.0f, ladspa++ %.0f\n",
+		"", naive_label, block_ns / naive_ns, block_ns / fast_ns);
+}
+
+int main()
+{
+	std::vector<data> out(block), freq(block, 440), fm(block);
+	for(std::size_t i = 0; i < block; ++i)
+		fm[i] = 100 * std::sin(two_pi * i / 64);
+	std::vector<data> fm_freq(block);
+	for(std::size_t i = 0; i < block; ++i)
+		fm_freq[i] = 440 + fm[i];
+
+	naive_sine sine;
+	oscillator osc(waveform::sine, rate);
+	report("sine, 440 Hz",
+		bench::measure([&]() {
+			sine.process(freq.data(), out.data(), block);
+			bench::clobber(out.data()); }),
+		bench::measure([&]() {
+			osc.process(440, out.data(), block);
+			bench::clobber(out.data()); }));
+	report("sine, 440 Hz, audio rate FM",
+		bench::measure([&]() {
+			sine.process(fm_freq.data(), out.data(), block);
+			bench::clobber(out.data()); }),
+		bench::measure([&]() {
+			osc.process(440, fm.data(), out.data(), block);
+			bench::clobber(out.data()); }));
+
+	naive_saw saw;
+	osc.set_waveform(waveform::saw);
+	const double table_ns = bench::measure([&]() {
+		osc.process(440, out.data(), block);
+		bench::clobber(out.data()); });
+	report("saw, 440 Hz",
+		bench::measure([&]() {
+			saw.process(440, out.data(), block);
+			bench::clobber(out.data()); }),
+		table_ns);
+
+	// the same quality without tables, for reference
+	additive_saw additive;
+	report("band-limited saw, 440 Hz",
+		bench::measure([&]() {
+			additive.process(440, out.data(), block);
+			bench::clobber(out.data()); }),
+		table_ns, "additive");
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,129 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#include <cstdlib>
+
+#include "ladspa++.h"
+#include "bench.h"
+
+using namespace ladspa;
+
+static constexpr std::size_t block = 256;
+static constexpr std::size_t calls = 64;
+
+//! a stereo gain, with or without the output guard
+template<guard_mode Mode>
+struct stereo_gain
+{
+	enum class port_names
+	{
+		gain,
+		in_l,
+		in_r,
+		out_l,
+		out_r,
+		size
+	};
+
+	static constexpr port_info_t port_info[] =
+	{
+		{ "Gain", "Amount of multiplication.",
+			port_types::input | port_types::control,
+			{port_hints::default_1, 0} },
+		port_info_common::audio_input,
+		port_info_common::audio_input,
+		port_info_common::audio_output,
+		port_info_common::audio_output,
+		port_info_common::final_port
+	};
+
+	static constexpr info_t info =
+	{
+		4300 + (unsigned long)Mode,
+		"bench_stereo_gain",
+		properties::hard_rt_capable,
+		"Stereo gain (output guard benchmark)",
+		"Johannes Lorenz",
+		"Multiplies both channels by the gain.",
+		{"gain"},
+		strings::copyright::gpl3,
+		nullptr
+	};
+
+	static constexpr output_guard_t output_guard = { Mode, 4 };
+
+	void run(port_array_t<port_names, port_info>& ports)
+	{
+		const data gain = ports.template get<port_names::gain>();
+		const_buffer in_l = ports.template get<port_names::in_l>();
+		const_buffer in_r = ports.template get<port_names::in_r>();
+		buffer out_l = ports.template get<port_names::out_l>();
+		buffer out_r = ports.template get<port_names::out_r>();
+		for(std::size_t i = 0; i < out_l.size(); ++i)
+		{
+			out_l[i] = in_l[i] * gain;
+			out_r[i] = in_r[i] * gain;
+		}
+	}
+};
+
+template<guard_mode Mode>
+constexpr port_info_t stereo_gain<Mode>::port_info[];
+template<guard_mode Mode>
+constexpr info_t stereo_gain<Mode>::info;
+template<guard_mode Mode>
+constexpr output_guard_t stereo_gain<Mode>::output_guard;
+
+static data buffers[5][block];
+
+//! time of @a calls run() calls of plugin @a P
+template<class P>
+static double measure()
+{
+	const LADSPA_Descriptor* d = collection<P>::get_ladspa_descriptor(0);
+	LADSPA_Handle h = d->instantiate(d, 48000);
+	buffers[0][0] = 0.5f;
+	for(port_size_t p = 0; p < 5; ++p)
+		d->connect_port(h, p, buffers[p]);
+	const double res = bench::measure([&]() {
+		for(std::size_t i = 0; i < calls; ++i)
+			d->run(h, block);
+		bench::clobber(buffers); });
+	d->cleanup(h);
+	return res / calls;
+}
+
+int main()
+{
+	for(std::size_t c = 1; c < 3; ++c)
+	for(data& x : buffers[c])
+		x = std::rand() / (data)RAND_MAX * 2 - 1;
+
+	std::printf("Cost of the output guard per block of %zu stereo "
+		"samples:\n", block);
+	bench::report("guard_mode::zero",
+		measure<stereo_gain<guard_mode::off>>(),
+		measure<stereo_gain<guard_mode::zero>>(), "unguarded");
+	bench::report("guard_mode::hold",
+		measure<stereo_gain<guard_mode::off>>(),
+		measure<stereo_gain<guard_mode::hold>>(), "unguarded");
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,155 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+
+/*
+ * This is plain C, like plugins without ladspa++ are written. See
+ * CMakeLists.txt for why it is compiled by the C++ compiler anyways.
+ */
+
+#include <stdlib.h>
+
+#include "raw_plugins.h"
+
+#define MIXER_CHANNELS 8
+
+typedef struct
+{
+	LADSPA_Data* ports[2 * MIXER_CHANNELS + 1];
+	LADSPA_Data state;
+} raw_plugin;
+
+static LADSPA_Handle instantiate(const LADSPA_Descriptor* d,
+	unsigned long rate)
+{
+	raw_plugin* p = (raw_plugin*)calloc(1, sizeof(raw_plugin));
+	(void)d;
+	(void)rate;
+	return p;
+}
+
+static void connect_port(LADSPA_Handle h, unsigned long port,
+	LADSPA_Data* data)
+{
+	((raw_plugin*)h)->ports[port] = data;
+}
+
+static void activate(LADSPA_Handle h)
+{
+	((raw_plugin*)h)->state = 0;
+}
+
+static void cleanup(LADSPA_Handle h)
+{
+	free(h);
+}
+
+/* ports: gain, input, output */
+static void run_amplifier(LADSPA_Handle h, unsigned long n)
+{
+	LADSPA_Data** ports = ((raw_plugin*)h)->ports;
+	const LADSPA_Data gain = *ports[0];
+	const LADSPA_Data* in = ports[1];
+	LADSPA_Data* out = ports[2];
+	unsigned long i;
+	for(i = 0; i < n; ++i)
+		out[i] = in[i] * gain;
+}
+
+/* ports: gain, input l, input r, output l, output r */
+static void run_stereo_amplifier(LADSPA_Handle h, unsigned long n)
+{
+	LADSPA_Data** ports = ((raw_plugin*)h)->ports;
+	const LADSPA_Data gain = *ports[0];
+	const LADSPA_Data *in_l = ports[1], *in_r = ports[2];
+	LADSPA_Data *out_l = ports[3], *out_r = ports[4];
+	unsigned long i;
+	for(i = 0; i < n; ++i)
+	{
+		out_l[i] = in_l[i] * gain;
+		out_r[i] = in_r[i] * gain;
+	}
+}
+
+/* ports: coefficient, input, output */
+static void run_lowpass(LADSPA_Handle h, unsigned long n)
+{
+	raw_plugin* p = (raw_plugin*)h;
+	const LADSPA_Data k = *p->ports[0];
+	const LADSPA_Data* in = p->ports[1];
+	LADSPA_Data* out = p->ports[2];
+	LADSPA_Data state = p->state;
+	unsigned long i;
+	for(i = 0; i < n; ++i)
+		out[i] = state += k * (in[i] - state);
+	p->state = state;
+}
+
+/* ports: gains, inputs, output */
+static void run_mixer(LADSPA_Handle h, unsigned long n)
+{
+	LADSPA_Data** ports = ((raw_plugin*)h)->ports;
+	LADSPA_Data* out = ports[2 * MIXER_CHANNELS];
+	const LADSPA_Data* in[MIXER_CHANNELS];
+	LADSPA_Data gain[MIXER_CHANNELS];
+	unsigned long c, i;
+	for(c = 0; c < MIXER_CHANNELS; ++c)
+	{
+		in[c] = ports[MIXER_CHANNELS + c];
+		gain[c] = *ports[c];
+	}
+	/* read all inputs of a sample before writing it, out may alias one */
+	for(i = 0; i < n; ++i)
+	{
+		LADSPA_Data sum = in[0][i] * gain[0];
+		for(c = 1; c < MIXER_CHANNELS; ++c)
+			sum += in[c][i] * gain[c];
+		out[i] = sum;
+	}
+}
+
+static LADSPA_Descriptor descriptors[4];
+
+static void init_descriptor(LADSPA_Descriptor* d, const char* label,
+	unsigned long ports, void (*run)(LADSPA_Handle, unsigned long))
+{
+	d->Label = label;
+	d->Name = label;
+	d->PortCount = ports;
+	d->instantiate = instantiate;
+	d->connect_port = connect_port;
+	d->activate = activate;
+	d->run = run;
+	d->cleanup = cleanup;
+}
+
+const LADSPA_Descriptor* raw_descriptor(unsigned long index)
+{
+	if(!descriptors[0].run)
+	{
+		init_descriptor(descriptors + 0, "amplifier", 3, run_amplifier);
+		init_descriptor(descriptors + 1, "stereo amplifier", 5,
+			run_stereo_amplifier);
+		init_descriptor(descriptors + 2, "lowpass", 3, run_lowpass);
+		init_descriptor(descriptors + 3, "mixer", 2 * MIXER_CHANNELS + 1,
+			run_mixer);
+	}
+	return (index < 4) ? descriptors + index : NULL;
+}
@@ -0,0 +1,41 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+
+#ifndef LADSPAPP_RAW_PLUGINS_H
+#define LADSPAPP_RAW_PLUGINS_H
+
+#include <ladspa.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Hand written C versions of the benchmarked plugins, in the style of the
+ * LADSPA SDK: 0 amplifier, 1 stereo amplifier, 2 lowpass, 3 8 channel mixer
+ */
+const LADSPA_Descriptor* raw_descriptor(unsigned long index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LADSPAPP_RAW_PLUGINS_H */
@@ -0,0 +1,116 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ladspa++.h"
+#include "ladspa++/stateless.h"
+#include "bench.h"
+
+using namespace ladspa;
+
+//! one offline block
+static constexpr std::size_t block = 1 << 20;
+
+template<bool Stateless>
+struct saturator
+{
+	enum class port_names
+	{
+		in_1,
+		out_1,
+		size
+	};
+
+	static constexpr port_info_t port_info[] =
+	{
+		port_info_common::audio_input,
+		port_info_common::audio_output,
+		port_info_common::final_port
+	};
+
+	static constexpr info_t info =
+	{
+		4293, "saturator", properties::hard_rt_capable,
+		"Saturator", "", "", {}, strings::copyright::gpl3, nullptr
+	};
+
+	static constexpr bool stateless = Stateless;
+
+	void run(port_array_t<port_names, port_info>& ports)
+	{
+		const_buffer in = ports.template get<port_names::in_1>();
+		buffer out = ports.template get<port_names::out_1>();
+		for(std::size_t i = 0; i < out.size(); ++i)
+			out[i] = std::tanh(in[i] * 4);
+	}
+};
+
+template<bool Stateless>
+constexpr port_info_t saturator<Stateless>::port_info[];
+template<bool Stateless>
+constexpr info_t saturator<Stateless>::info;
+
+template<class Plugin>
+static double measure(data* in, data* out)
+{
+	const LADSPA_Descriptor* d
+		= collection<Plugin>::get_ladspa_descriptor(0);
+	LADSPA_Handle h = d->instantiate(d, 48000);
+	d->connect_port(h, 0, in);
+	d->connect_port(h, 1, out);
+	const double res = bench::measure([&]() {
+		d->run(h, block);
+		bench::clobber(out); }, 1);
+	d->cleanup(h);
+	return res;
+}
+
+int main()
+{
+	// the pool is only there if the host asks for it, so ask. the bench
+	// target also runs this with fixed thread counts, to show the scaling
+	if(!std::getenv("LADSPAPP_THREADS"))
+		setenv("LADSPAPP_THREADS", std::to_string(
+			std::thread::hardware_concurrency()).c_str(), 1);
+	const char* threads = std::getenv("LADSPAPP_THREADS");
+	std::printf("threads: %s, cores: %u\n", threads,
+		std::thread::hardware_concurrency());
+
+	std::vector<data> in(block), out(block);
+	for(data& x : in)
+		x = std::rand() / (data)RAND_MAX * 2 - 1;
+
+	const std::string name = std::string("saturator, 2^20 samples, ")
+		+ threads + " threads";
+	bench::report(name.c_str(),
+		measure<saturator<false>>(in.data(), out.data()),
+		measure<saturator<true>>(in.data(), out.data()), "serial");
+	bench::report((name + ", in place").c_str(),
+		measure<saturator<false>>(in.data(), in.data()),
+		measure<saturator<true>>(in.data(), in.data()), "serial");
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,173 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include "ladspa++.h"
+#include "bench.h"
+
+using namespace ladspa;
+
+static constexpr std::size_t block = 256;
+
+//! the ports of both plugins
+struct shaper_base
+{
+	enum class port_names
+	{
+		mode,
+		in_1,
+		out_1,
+		size
+	};
+
+	static constexpr port_info_t port_info[] =
+	{
+		{ "Mode",
+			"0 = hard clip, 1 = soft clip, 2 = cubic.",
+			port_types::input | port_types::control,
+			{(port_hints::bounded_below
+			| port_hints::bounded_above
+			| port_hints::integer
+			| port_hints::default_minimum),
+			0, 2
+			} },
+		port_info_common::audio_input,
+		port_info_common::audio_output,
+		port_info_common::final_port
+	};
+};
+
+constexpr port_info_t shaper_base::port_info[];
+
+typedef port_array_t<shaper_base::port_names, shaper_base::port_info>
+	shaper_port_array;
+
+template<int Mode>
+static data shape(data x)
+{
+	return (Mode == 0) ? std::max(-1.0f, std::min(1.0f, x))
+		: (Mode == 1) ? x / (1 + std::fabs(x))
+		: std::max(-1.0f, std::min(1.0f, x - x * x * x / 3));
+}
+
+//! what most plugins do: branch on the mode port in the loop, which is
+//! read for each sample, since the output may alias it
+struct naive_shaper : public shaper_base
+{
+	static constexpr info_t info =
+	{
+		4291, "naive_shaper", properties::hard_rt_capable,
+		"Naive Shaper", "", "", {}, strings::copyright::gpl3, nullptr
+	};
+
+	void run(shaper_port_array& ports)
+	{
+		const data* mode = &(const data&)ports.get<port_names::mode>();
+		const_buffer in = ports.get<port_names::in_1>();
+		buffer out = ports.get<port_names::out_1>();
+		for(std::size_t i = 0; i < out.size(); ++i)
+		{
+			switch((int)*mode)
+			{
+				case 0: out[i] = shape<0>(in[i]); break;
+				case 1: out[i] = shape<1>(in[i]); break;
+				default: out[i] = shape<2>(in[i]);
+			}
+		}
+	}
+};
+
+//! the same plugin, with one run() variant per mode
+struct variant_shaper : public shaper_base
+{
+	static constexpr info_t info =
+	{
+		4292, "variant_shaper", properties::hard_rt_capable,
+		"Variant Shaper", "", "", {}, strings::copyright::gpl3, nullptr
+	};
+	static constexpr variant_port_t<port_names> variant_port
+		= { port_names::mode, 64 };
+
+	template<int Mode>
+	void run(shaper_port_array& ports)
+	{
+		const_buffer in = ports.get<port_names::in_1>();
+		buffer out = ports.get<port_names::out_1>();
+		for(std::size_t i = 0; i < out.size(); ++i)
+			out[i] = shape<Mode>(in[i]);
+	}
+};
+
+constexpr info_t naive_shaper::info;
+constexpr info_t variant_shaper::info;
+constexpr variant_port_t<shaper_base::port_names>
+	variant_shaper::variant_port;
+
+int main()
+{
+	std::vector<data> in(block), out(block);
+	for(data& x : in)
+		x = std::rand() / (data)RAND_MAX * 4 - 2;
+	data mode = 1;
+
+	const LADSPA_Descriptor* naive
+		= collection<naive_shaper>::get_ladspa_descriptor(0);
+	const LADSPA_Descriptor* variants
+		= collection<variant_shaper>::get_ladspa_descriptor(0);
+	LADSPA_Handle naive_handle = naive->instantiate(naive, 48000),
+		variant_handle = variants->instantiate(variants, 48000);
+	for(const LADSPA_Descriptor* d : { naive, variants })
+	{
+		LADSPA_Handle h = (d == naive) ? naive_handle : variant_handle;
+		d->connect_port(h, 0, &mode);
+		d->connect_port(h, 1, in.data());
+		d->connect_port(h, 2, out.data());
+	}
+
+	bench::report("shaper, fixed mode",
+		bench::measure([&]() {
+			naive->run(naive_handle, block);
+			bench::clobber(out.data()); }),
+		bench::measure([&]() {
+			variants->run(variant_handle, block);
+			bench::clobber(out.data()); }),
+		"per sample");
+
+	// a new mode in each block, so each block is crossfaded
+	int count = 0;
+	bench::report("shaper, mode changes per block",
+		bench::measure([&]() {
+			mode = (++count % 3);
+			naive->run(naive_handle, block);
+			bench::clobber(out.data()); }),
+		bench::measure([&]() {
+			mode = (++count % 3);
+			variants->run(variant_handle, block);
+			bench::clobber(out.data()); }),
+		"per sample");
+
+	naive->cleanup(naive_handle);
+	variants->cleanup(variant_handle);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,258 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+
+/*
+ * Checks that plugins written with ladspa++ are as fast as the same
+ * plugins written in plain C. Both are run through their ladspa
+ * descriptors, like a host would do.
+ *
+ * usage: bench_zero_cost [<threshold> [<json file> [<history file>
+ *   [<source dir>]]]]
+ * Fails if any ladspa++ plugin needs more than threshold times the time of
+ * its C counterpart.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "ladspa++.h"
+#include "bench.h"
+#include "raw_plugins.h"
+
+using namespace ladspa;
+
+/*
+ * ladspa++ versions, in the style of the examples
+ * (the amplifier is examples/amplifier.cpp)
+ */
+
+struct stereo_amplifier
+{
+	enum class port_names { gain, in_l, in_r, out_l, out_r, size };
+
+	static constexpr port_info_t port_info[] =
+	{
+		{ "Gain", "Amount of multiplication.",
+			port_types::input | port_types::control,
+			{port_hints::default_1, 0, 0} },
+		port_info_common::audio_input_l,
+		port_info_common::audio_input_r,
+		port_info_common::audio_output_l,
+		port_info_common::audio_output_r,
+		port_info_common::final_port
+	};
+
+	static constexpr info_t info = { 1, "stereo_amplifier",
+		properties::hard_rt_capable, "Stereo Amplifier", "", "",
+		{}, strings::copyright::gpl3, nullptr };
+
+	void run(port_array_t<port_names, port_info>& ports)
+	{
+		const data gain = ports.get<port_names::gain>();
+		for(auto& ptrs : ports.buffers<port_names::in_l, port_names::in_r,
+			port_names::out_l, port_names::out_r>())
+		{
+			ptrs.get<port_names::out_l>() = ptrs.get<port_names::in_l>()
+				* gain;
+			ptrs.get<port_names::out_r>() = ptrs.get<port_names::in_r>()
+				* gain;
+		}
+	}
+};
+
+struct lowpass
+{
+	enum class port_names { coefficient, in, out, size };
+
+	static constexpr port_info_t port_info[] =
+	{
+		{ "Coefficient", "Amount of the new input per sample.",
+			port_types::input | port_types::control,
+			{port_hints::bounded_below | port_hints::bounded_above, 0, 1} },
+		port_info_common::audio_input,
+		port_info_common::audio_output,
+		port_info_common::final_port
+	};
+
+	static constexpr info_t info = { 2, "lowpass",
+		properties::hard_rt_capable, "Lowpass", "", "",
+		{}, strings::copyright::gpl3, nullptr };
+
+	data state = 0;
+
+	void activate() { state = 0; }
+
+	void run(port_array_t<port_names, port_info>& ports)
+	{
+		const data k = ports.get<port_names::coefficient>();
+		const_buffer in = ports.get<port_names::in>();
+		buffer out = ports.get<port_names::out>();
+		data s = state;
+		for(std::size_t i = 0; i < out.size(); ++i)
+			out[i] = s += k * (in[i] - s);
+		state = s;
+	}
+};
+
+struct mixer
+{
+	static constexpr port_size_t channels = 8;
+
+	enum class port_names { gains, inputs, out, size };
+
+	static constexpr port_info_t port_info[] =
+	{
+		port_info_t { "Gain", "Amount of multiplication for one channel.",
+			port_types::input | port_types::control,
+			{port_hints::default_1, 0, 0} }.group(channels),
+		port_info_common::audio_input.group(channels),
+		port_info_common::audio_output,
+		port_info_common::final_port
+	};
+
+	static constexpr info_t info = { 3, "mixer",
+		properties::hard_rt_capable, "Mixer", "", "",
+		{}, strings::copyright::gpl3, nullptr };
+
+	void run(port_array_t<port_names, port_info>& ports)
+	{
+		auto gains = ports.get<port_names::gains>();
+		auto inputs = ports.get<port_names::inputs>();
+		buffer out = ports.get<port_names::out>();
+		const data* const* in_ptrs = inputs.data();
+		const data* in[channels];
+		data gain[channels];
+		for(std::size_t c = 0; c < channels; ++c)
+		{
+			in[c] = in_ptrs[c];
+			gain[c] = gains[c];
+		}
+
+		// each sample reads all inputs before the output is written,
+		// so the host may pass the output as one of the inputs
+		for(std::size_t i = 0; i < out.size(); ++i)
+		{
+			data sum = in[0][i] * gain[0];
+			for(std::size_t c = 1; c < channels; ++c)
+				sum += in[c][i] * gain[c];
+			out[i] = sum;
+		}
+	}
+};
+
+typedef collection<stereo_amplifier, lowpass, mixer> ladspapp_plugins;
+
+/*
+ * host side
+ */
+
+static constexpr std::size_t block = 256;
+//! run() calls per measurement, so the clock's overhead does not count
+static constexpr std::size_t calls = 64;
+static constexpr std::size_t max_ports = 17;
+
+//! one buffer per port, shared by all measurements, so the C and the
+//! ladspa++ versions work on exactly the same addresses
+alignas(cache_line_size) static data buffers[max_ports][block];
+
+//! Measures one run() call of @a d, with all audio inputs connected to
+//! noise, and all control inputs to @a control
+static double measure(const LADSPA_Descriptor* d, data control)
+{
+	assert(d->PortCount <= max_ports);
+	std::srand(0);
+	for(port_size_t p = 0; p < d->PortCount; ++p)
+	{
+		for(data& x : buffers[p])
+			x = std::rand() / (data)RAND_MAX * 2 - 1;
+		buffers[p][0] = control;
+	}
+
+	LADSPA_Handle h = d->instantiate(d, 48000);
+	for(port_size_t p = 0; p < d->PortCount; ++p)
+		d->connect_port(h, p, buffers[p]);
+	if(d->activate)
+		d->activate(h);
+	const double ns = bench::measure([&]() {
+		for(std::size_t i = 0; i < calls; ++i)
+		{
+			d->run(h, block);
+			bench::clobber(buffers);
+		}
+	}) / calls;
+	d->cleanup(h);
+	return ns;
+}
+
+//! Returns the current git commit of @a source_dir, or "unknown"
+static std::string commit_of(const char* source_dir)
+{
+	std::string res = "unknown";
+	const std::string cmd = std::string("git -C \"") + source_dir
+		+ "\" rev-parse --short HEAD 2>/dev/null";
+	if(std::FILE* p = popen(cmd.c_str(), "r"))
+	{
+		char buf[64];
+		if(std::fgets(buf, sizeof(buf), p))
+			res.assign(buf, std::strcspn(buf, "\n"));
+		pclose(p);
+	}
+	return res;
+}
+
+//! best of some alternating measurements, to filter out noise
+static void compare(bench::suite& results, const char* name,
+	const LADSPA_Descriptor* raw, const LADSPA_Descriptor* ladspapp)
+{
+	double raw_ns = 1e300, ladspapp_ns = 1e300;
+	for(int round = 0; round < 3; ++round)
+	{
+		raw_ns = std::min(raw_ns, measure(raw, 0.5f));
+		ladspapp_ns = std::min(ladspapp_ns, measure(ladspapp, 0.5f));
+	}
+	results.add(name, raw_ns, ladspapp_ns);
+}
+
+int main(int argc, char** argv)
+{
+	const double threshold = (argc > 1) ? std::atof(argv[1]) : 1.1;
+
+	bench::suite results("C");
+	compare(results, "amplifier", raw_descriptor(0), ladspa_descriptor(0));
+	const char* names[] = { "stereo amplifier", "lowpass", "8 channel mixer" };
+	for(unsigned long i = 0; i < 3; ++i)
+		compare(results, names[i], raw_descriptor(i + 1),
+			ladspapp_plugins::get_ladspa_descriptor(i));
+
+	if(argc > 2 && !results.write_json(argv[2], (argc > 3) ? argv[3]
+		: nullptr, commit_of((argc > 4) ? argv[4] : ".").c_str()))
+	{
+		std::fprintf(stderr, "Can not write %s\n", argv[2]);
+		return EXIT_FAILURE;
+	}
+
+	const double worst = results.worst_ratio();
+	std::printf("worst ratio of ladspa++ to C: %.2f (threshold: %.2f)\n",
+		worst, threshold);
+	return (worst > threshold) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -19,6 +19,8 @@
 /*************************************************************************/
 
 #include "ladspa++.h"
+#include "ladspa++/stateless.h"
+#include "ladspa++/expression.h"
 
 using namespace ladspa;
 
@@ -61,6 +63,10 @@ struct amplifier
 		strings::copyright::gpl3,
 		nullptr // implementation data
 	};
+
+	// each sample only depends on the same input sample, so offline
+	// hosts may split large blocks and run the parts in parallel
+	static constexpr bool stateless = true;
 	
 	void run(port_array_t<port_names, port_info>& ports)
 	{
@@ -80,16 +86,10 @@ struct amplifier
 			out_buffer[i] = 0;
 		}*/
 		
-		// the new way
-		auto container = ports.buffers<
-			port_names::in_1,
-			port_names::out_1>();
-		
-		for( auto& ptrs : container ) {
-			ptrs.get<port_names::out_1>()
-				= ptrs.get<port_names::in_1>()
-				* ports.get<port_names::value>();
-		}
+		// the new way: with expressions, this compiles to one loop
+		buffer out_buffer = ports.get<port_names::out_1>();
+		out_buffer = ports.get<port_names::in_1>()
+			* ports.get<port_names::value>();
 
 	}
 	
@@ -97,6 +97,10 @@ struct amplifier
 	// amplifier(sample_rate_t _sample_rate) {}
 };
 
+// connecting the ports and starting run() touch only one cache line
+static_assert(footprint<amplifier>::port_cache_lines == 1,
+	"The amplifier's ports should fit into one cache line.");
+
 /*
  * to be called by ladspa
  */
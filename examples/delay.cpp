@@ -0,0 +1,100 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#include "ladspa++.h"
+#include "ladspa++/delay_line.h"
+
+using namespace ladspa;
+
+struct delay
+{
+	static constexpr data max_delay_ms = 1000.0f;
+
+	enum class port_names
+	{
+		time,
+		in_1,
+		out_1,
+		size
+	};
+	
+	static constexpr port_info_t port_info[] =
+	{
+		{ "Delay (ms)",
+			"Time by which the input signal is delayed.",
+			port_types::input | port_types::control,
+			{(port_hints::bounded_below
+			| port_hints::bounded_above
+			| port_hints::default_100),
+			0, max_delay_ms
+			} },
+		port_info_common::audio_input,
+		port_info_common::audio_output,
+		port_info_common::final_port
+	};
+
+	static constexpr info_t info =
+	{
+		4244, // unique id
+		"delay_mono_pp", // label for lookup
+		properties::hard_rt_capable,
+		"Mono Delay (ladspa++ version)", // name
+		"Johannes Lorenz", // author
+		"This effect delays the input signal.",
+		{"delay", "echo"},
+		strings::copyright::gpl3,
+		nullptr // implementation data
+	};
+
+	sample_rate_t sample_rate;
+	delay_line line;
+
+	delay(sample_rate_t _sample_rate) : sample_rate(_sample_rate) {}
+
+	// called by the host before running, so allocations are allowed
+	void activate()
+	{
+		line.allocate(max_delay_ms * sample_rate / 1000);
+	}
+	
+	void run(port_array_t<port_names, port_info>& ports)
+	{
+		const_buffer in = ports.get<port_names::in_1>();
+		buffer out = ports.get<port_names::out_1>();
+		data ms = ports.get<port_names::time>();
+		ms = std::max(0.0f, std::min(max_delay_ms, ms));
+
+		line.process(in.data(), out.data(), out.size(),
+			std::min<std::size_t>(ms * sample_rate / 1000,
+				line.max_delay()));
+	}
+};
+
+constexpr data delay::max_delay_ms;
+
+/*
+ * to be called by ladspa
+ */
+
+const LADSPA_Descriptor * 
+ladspa_descriptor(plugin_index_t index) {
+	return collection<delay>::get_ladspa_descriptor(index);
+}
+
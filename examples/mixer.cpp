@@ -0,0 +1,103 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#include "ladspa++.h"
+
+using namespace ladspa;
+
+struct mixer
+{
+	static constexpr port_size_t channels = 8;
+
+	// one entry per port group, not per channel
+	enum class port_names
+	{
+		gains,
+		inputs,
+		out,
+		size
+	};
+	
+	static constexpr port_info_t port_info[] =
+	{
+		// expands to the ladspa ports "Gain 1" ... "Gain 8"
+		port_info_t { "Gain",
+			"Amount of multiplication for one channel.",
+			port_types::input | port_types::control,
+			{(port_hints::bounded_below
+			| port_hints::default_1),
+			0
+			} }.group(channels),
+		// expands to the ladspa ports "Input 1" ... "Input 8"
+		port_info_common::audio_input.group(channels),
+		port_info_common::audio_output,
+		port_info_common::final_port
+	};
+
+	static constexpr info_t info =
+	{
+		4243, // unique id
+		"mixer_8_pp", // label for lookup
+		properties::hard_rt_capable,
+		"8 Channel Mixer (ladspa++ version)", // name
+		"Johannes Lorenz", // author
+		"This effect sums up all inputs, each multiplied by its gain.",
+		{"mixer", "gain", "volume"},
+		strings::copyright::gpl3,
+		nullptr // implementation data
+	};
+	
+	void run(port_array_t<port_names, port_info>& ports)
+	{
+		auto gains = ports.get<port_names::gains>();
+		auto inputs = ports.get<port_names::inputs>();
+		buffer out = ports.get<port_names::out>();
+
+		// all channel pointers are contiguous
+		const data* const* in_ptrs = inputs.data();
+		const data* in[channels];
+		data gain[channels];
+		for(std::size_t c = 0; c < channels; ++c)
+		{
+			in[c] = in_ptrs[c];
+			gain[c] = gains[c];
+		}
+
+		// each sample reads all inputs before the output is written,
+		// so the host may pass the output as one of the inputs
+		for(std::size_t i = 0; i < out.size(); ++i)
+		{
+			data sum = in[0][i] * gain[0];
+			for(std::size_t c = 1; c < channels; ++c)
+				sum += in[c][i] * gain[c];
+			out[i] = sum;
+		}
+	}
+};
+
+/*
+ * to be called by ladspa
+ */
+
+const LADSPA_Descriptor * 
+ladspa_descriptor(plugin_index_t index) {
+	return collection<mixer>::get_ladspa_descriptor(index);
+}
+
@@ -0,0 +1,113 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+
+#include "ladspa++.h"
+#include "ladspa++/oscillator.h"
+
+using namespace ladspa;
+
+struct wavetable_oscillator
+{
+	static constexpr unsigned waveforms = 4;
+
+	enum class port_names
+	{
+		frequency,
+		shape,
+		fm,
+		out_1,
+		size
+	};
+	
+	static constexpr port_info_t port_info[] =
+	{
+		{ "Frequency (Hz)",
+			"Base frequency of the oscillator.",
+			port_types::input | port_types::control,
+			{(port_hints::bounded_below
+			| port_hints::bounded_above
+			| port_hints::logarithmic
+			| port_hints::default_440),
+			1, 20000
+			} },
+		{ "Waveform",
+			"0 = sine, 1 = saw, 2 = square, 3 = triangle.",
+			port_types::input | port_types::control,
+			{(port_hints::bounded_below
+			| port_hints::bounded_above
+			| port_hints::integer
+			| port_hints::default_minimum),
+			0, waveforms - 1
+			} },
+		{ "FM (Hz)",
+			"Added to the frequency, sample by sample.",
+			port_types::input | port_types::audio,
+			{ port_hints::default_none, 0, 0 } },
+		port_info_common::audio_output,
+		port_info_common::final_port
+	};
+
+	static constexpr info_t info =
+	{
+		4246, // unique id
+		"oscillator_mono_pp", // label for lookup
+		properties::hard_rt_capable,
+		"Wavetable Oscillator (ladspa++ version)", // name
+		"Johannes Lorenz", // author
+		"A band-limited oscillator with audio rate FM.",
+		{"oscillator", "generator", "synth"},
+		strings::copyright::gpl3,
+		nullptr // implementation data
+	};
+
+	// the tables are the same for all instances, and are all looked up
+	// here, so switching waveforms in run() does not allocate
+	std::shared_ptr<const wavetable> tables[waveforms];
+	oscillator osc;
+
+	wavetable_oscillator(sample_rate_t sample_rate)
+	: osc(waveform::sine, sample_rate)
+	{
+		for(unsigned w = 0; w < waveforms; ++w)
+			tables[w] = wavetable::get(static_cast<waveform>(w));
+	}
+
+	void activate() { osc.reset(); }
+	
+	void run(port_array_t<port_names, port_info>& ports)
+	{
+		const data shape = ports.get<port_names::shape>();
+		osc.set_tables(tables[std::min<unsigned>(
+			std::max(0.0f, shape), waveforms - 1)]);
+		osc.process(ports.get<port_names::frequency>(),
+			ports.get<port_names::fm>(),
+			ports.get<port_names::out_1>());
+	}
+};
+
+/*
+ * to be called by ladspa
+ */
+
+const LADSPA_Descriptor * 
+ladspa_descriptor(plugin_index_t index) {
+	return collection<wavetable_oscillator>::get_ladspa_descriptor(index);
+}
@@ -0,0 +1,115 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+
+#include <cmath>
+
+#include "ladspa++.h"
+#include "ladspa++/fft.h"
+#include "ladspa++/frame_adapter.h"
+#include "ladspa++/shared_resource.h"
+
+using namespace ladspa;
+
+struct spectral_gate
+{
+	static constexpr std::size_t frame = 1024, hop = 256;
+
+	enum class port_names
+	{
+		threshold,
+		in_1,
+		out_1,
+		latency,
+		size
+	};
+	
+	static constexpr port_info_t port_info[] =
+	{
+		{ "Threshold (dB)",
+			"Frequency bins below this level are removed.",
+			port_types::input | port_types::control,
+			{(port_hints::bounded_below
+			| port_hints::bounded_above
+			| port_hints::default_low),
+			-120, 0
+			} },
+		port_info_common::audio_input,
+		port_info_common::audio_output,
+		port_info_common::latency,
+		port_info_common::final_port
+	};
+
+	static constexpr info_t info =
+	{
+		4245, // unique id
+		"spectral_gate_mono_pp", // label for lookup
+		properties::hard_rt_capable,
+		"Mono Spectral Gate (ladspa++ version)", // name
+		"Johannes Lorenz", // author
+		"This effect removes all frequencies which are quieter than "
+			"the threshold.",
+		{"gate", "denoise", "spectral"},
+		strings::copyright::gpl3,
+		nullptr // implementation data
+	};
+
+	// the twiddle tables are the same for all instances
+	std::shared_ptr<const fft> transform;
+	frame_adapter<frame, hop> adapter;
+	data re[frame / 2 + 1], im[frame / 2 + 1];
+
+	spectral_gate()
+	: transform(shared_resource<fft, std::size_t>::get(std::size_t(frame))) {}
+
+	void activate() { adapter.reset(); }
+	
+	void run(port_array_t<port_names, port_info>& ports)
+	{
+		const_buffer in = ports.get<port_names::in_1>();
+		buffer out = ports.get<port_names::out_1>();
+		data& latency = ports.get<port_names::latency>();
+		latency = adapter.latency();
+
+		// compare squared magnitudes, of the unnormalized fft
+		const data db = ports.get<port_names::threshold>();
+		const data level = std::pow(10.0f, db / 20) * frame / 2;
+		const data threshold = level * level;
+
+		adapter.process(in, out, [&](const data* x, data* y) {
+			transform->forward(x, re, im);
+			for(std::size_t k = 0; k < transform->bins(); ++k)
+			if(re[k] * re[k] + im[k] * im[k] < threshold)
+				re[k] = im[k] = 0;
+			transform->inverse(re, im, y);
+			for(std::size_t i = 0; i < frame; ++i)
+				y[i] *= 1.0f / frame;
+		});
+	}
+};
+
+/*
+ * to be called by ladspa
+ */
+
+const LADSPA_Descriptor * 
+ladspa_descriptor(plugin_index_t index) {
+	return collection<spectral_gate>::get_ladspa_descriptor(index);
+}
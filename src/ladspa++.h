@@ -18,12 +18,27 @@
 /* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
 /*************************************************************************/
 
-#include <tuple>
+#ifndef LADSPAPP_H
+#define LADSPAPP_H
+
 #include <array>
+#include <atomic>
 #include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 #include <ladspa.h>
 
+#ifdef LADSPAPP_TRACE
+#include "ladspa++/trace.h"
+#endif
+
 namespace ladspa
 {
 
@@ -51,49 +66,106 @@ struct full_seq
 namespace seq_helpers
 {
 
-template<int Start, int I, template<int> class Criterium, int ...Seq>
-struct _seq_recurse;
+/*
+ * All sequences are built with logarithmic instantiation depth,
+ * so plugins with hundreds of ports stay far below the template depth
+ * limits and do not need one instantiation per element and level.
+ */
+
+//! glues two sequences together
+template<class Lhs, class Rhs>
+struct _concat;
 
-//! @a cond is true => spawn @a I into seq and recurse
-template<int Start, int I, template<int> class Criterium, bool cond, int ...Seq>
-struct _seq_check
+template<int ...L, int ...R>
+struct _concat<full_seq<L...>, full_seq<R...>>
 {
-	using type = typename _seq_recurse<Start, I, Criterium, I, Seq...>::type;
+	using type = full_seq<L..., R...>;
 };
 
-//! @a cond is false => skip @a I in sequence and recurse
-template<int Start, int I, template<int> class Criterium, int ...Seq>
-struct _seq_check<Start, I, Criterium, false, Seq...>
+//! doubles [0, N) to [0, 2N), plus one more element if @a odd is true
+template<class Seq, int N, bool odd>
+struct _double;
+
+template<int ...Is, int N>
+struct _double<full_seq<Is...>, N, false>
 {
-	using type = typename _seq_recurse<Start, I, Criterium, Seq...>::type;
+	using type = full_seq<Is..., (N + Is)...>;
 };
 
-//! counting down, we have not reached the @a Start -> evaluate @a Criterium
-template<int Start, int I, template<int> class Criterium, int ...Seq>
-struct _seq
+template<int ...Is, int N>
+struct _double<full_seq<Is...>, N, true>
+{
+	using type = full_seq<Is..., (N + Is)..., 2 * N>;
+};
+
+//! creates [0, N) by halving @a N
+template<int N>
+struct _iota
+{
+	using type = typename _double<typename _iota<N/2>::type,
+		N/2, N%2>::type;
+};
+
+template<>
+struct _iota<0>
 {
-	using type = typename _seq_check<Start, I, Criterium, Criterium<I>::value, Seq...>::type;
+	using type = full_seq<>;
 };
 
-//! counting down, we have reached the @a Start
-template<int Start, template<int> class Criterium, int ...Seq>
-struct _seq<Start, Start, Criterium, Seq...>
+//! adds @a Offset to all elements
+template<class Seq, int Offset>
+struct _shift;
+
+template<int ...Is, int Offset>
+struct _shift<full_seq<Is...>, Offset>
 {
-	using type = full_seq<Seq...>;
+	using type = full_seq<(Is + Offset)...>;
 };
 
-//! sequence recursion, just decrements @a I
-template<int Start, int I, template<int> class Criterium, int ...Seq>
-struct _seq_recurse
+//! creates [Lo, Hi), filtered by @a Criterium, by bisecting the range
+template<int Lo, int Hi, template<int> class Criterium, int Len = Hi - Lo>
+struct _filter
 {
-	using type = typename _seq<Start, I-1, Criterium, Seq...>::type;
+	using type = typename _concat<
+		typename _filter<Lo, Lo + Len/2, Criterium>::type,
+		typename _filter<Lo + Len/2, Hi, Criterium>::type>::type;
+};
+
+//! empty range
+template<int Lo, int Hi, template<int> class Criterium>
+struct _filter<Lo, Hi, Criterium, 0>
+{
+	using type = full_seq<>;
+};
+
+//! one element => evaluate @a Criterium
+template<int Lo, int Hi, template<int> class Criterium>
+struct _filter<Lo, Hi, Criterium, 1>
+{
+	using type = typename std::conditional<Criterium<Lo>::value,
+		full_seq<Lo>, full_seq<>>::type;
+};
+
+//! creates [Lo, Hi), filtered by @a Criterium
+template<int Lo, int Hi, template<int> class Criterium>
+struct _seq
+{
+	using type = typename _filter<Lo, (Hi > Lo) ? Hi : Lo, Criterium>::type;
+};
+
+//! no filter => shift [0, Hi-Lo)
+template<int Lo, int Hi>
+struct _seq<Lo, Hi, criterium_true>
+{
+	using type = typename _shift<
+		typename _iota<(Hi > Lo) ? (Hi - Lo) : 0>::type, Lo>::type;
 };
 
 } // namespace seq_helpers
 
 //! creates maths like range, i.e. [Start, N]
 template<int N, int Start = 1, template<int> class Criterium = criterium_true>
-using math_seq = typename seq_helpers::_seq<Start-1, N, Criterium>::type;
+using math_seq = typename seq_helpers::_seq<Start, N+1, Criterium>::type;
 
 //! creates C like range, i.e. [Start-1, N-1]. Criterium is *not* counted for i-1
 template<int N, int Start = 0, template<int> class Criterium = criterium_true>
@@ -154,6 +226,34 @@ public:
 		sizeof( sfinae<T>( nullptr ) ) == sizeof( int32_t );
 };
 
+//! checks whether class @a T has a member function activate()
+template <typename T>
+class has_activate
+{
+	template <typename U>
+	static int32_t sfinae( decltype( std::declval<U&>().activate() ) * );
+	template <typename U>
+	static int8_t sfinae( ... );
+
+public:
+	static constexpr bool value =
+		sizeof( sfinae<T>( nullptr ) ) == sizeof( int32_t );
+};
+
+//! checks whether class @a T has a member function deactivate()
+template <typename T>
+class has_deactivate
+{
+	template <typename U>
+	static int32_t sfinae( decltype( std::declval<U&>().deactivate() ) * );
+	template <typename U>
+	static int8_t sfinae( ... );
+
+public:
+	static constexpr bool value =
+		sizeof( sfinae<T>( nullptr ) ) == sizeof( int32_t );
+};
+
 template <class T, template<class > class HaveClass>
 using en_if_has = typename std::enable_if<HaveClass<T>::value>::type;
 
@@ -165,27 +265,89 @@ using en_if_doesnt_have = typename std::enable_if<!HaveClass<T>::value>::type;
  */
 template<class T> struct identity {};
 
-//! if @a Type is the nth integer in @a Others, returns n
-template <std::size_t Type, std::size_t... Others>
-struct id_in_list;
+//! value of id_in_list if the id was not found
+constexpr std::size_t npos = -1;
 
-template <std::size_t Type>
-struct id_in_list<Type>
+//! literal array type, since std::array is not constexpr enough in C++11
+template<std::size_t N>
+struct id_array
+{
+	std::size_t ids[N];
+};
+
+/*
+ * All searches bisect [lo, hi), for logarithmic constexpr depth
+ */
+
+constexpr std::size_t first_found(std::size_t lhs, std::size_t rhs)
+{
+	return (lhs != npos) ? lhs : rhs;
+}
+
+//! linear search, for unsorted arrays
+template<std::size_t N>
+constexpr std::size_t find_id(const id_array<N>& arr, std::size_t id,
+	std::size_t lo, std::size_t hi)
 {
-	static constexpr size_t value = -1;
+	return (hi - lo == 1)
+		? ((arr.ids[lo] == id) ? lo : npos)
+		: first_found(find_id(arr, id, lo, lo + (hi - lo)/2),
+			find_id(arr, id, lo + (hi - lo)/2, hi));
+}
+
+//! binary search, for sorted arrays
+template<std::size_t N>
+constexpr std::size_t bsearch_id(const id_array<N>& arr, std::size_t id,
+	std::size_t lo, std::size_t hi)
+{
+	return (hi - lo == 1)
+		? ((arr.ids[lo] == id) ? lo : npos)
+		: (id < arr.ids[lo + (hi - lo)/2])
+			? bsearch_id(arr, id, lo, lo + (hi - lo)/2)
+			: bsearch_id(arr, id, lo + (hi - lo)/2, hi);
+}
+
+template<std::size_t N>
+constexpr bool is_sorted(const id_array<N>& arr,
+	std::size_t lo, std::size_t hi)
+{
+	return (hi - lo < 2) ||
+		(arr.ids[lo + (hi - lo)/2 - 1] < arr.ids[lo + (hi - lo)/2]
+		&& is_sorted(arr, lo, lo + (hi - lo)/2)
+		&& is_sorted(arr, lo + (hi - lo)/2, hi));
+}
+
+//! a list of ids which is only checked once for being sorted,
+//! so most lookups are logarithmic
+template <std::size_t... Ids>
+struct id_list
+{
+	static constexpr std::size_t size = sizeof...(Ids);
+	static constexpr id_array<size> ids = {{Ids...}};
+	static constexpr bool sorted = is_sorted(ids, 0, size);
+
+	static constexpr std::size_t find(std::size_t id)
+	{
+		return sorted
+			? bsearch_id(ids, id, 0, size)
+			: find_id(ids, id, 0, size);
+	}
 };
 
-template <std::size_t Type, std::size_t ... Others>
-struct id_in_list<Type, Type, Others...>
+template <std::size_t... Ids>
+constexpr id_array<id_list<Ids...>::size> id_list<Ids...>::ids;
+
+//! if @a Type is the nth integer in @a Others, returns n
+template <std::size_t Type, std::size_t... Others>
+struct id_in_list
 {
-	static constexpr size_t value = 0;
+	static constexpr std::size_t value = id_list<Others...>::find(Type);
 };
 
-template <std::size_t Type, std::size_t First, std::size_t ... Others>
-struct id_in_list<Type, First, Others...>
+template <std::size_t Type>
+struct id_in_list<Type>
 {
-	static constexpr size_t value
-		= id_in_list<Type, Others...>::value + 1;
+	static constexpr std::size_t value = npos;
 };
 
 } // namespace helpers
@@ -209,6 +371,9 @@ typedef unsigned long sample_rate_t;
 typedef unsigned long plugin_index_t;
 typedef LADSPA_Data data;
 
+//! Assumed size of a cache line, in bytes
+constexpr static std::size_t cache_line_size = 64;
+
 /**
  * @brief A simple, type safe implementation of a bitmask.
  *
@@ -305,6 +470,8 @@ class buffer_template
 	//! however, this overhead is not much
 	std::size_t _size;
 public:
+	typedef T value_type;
+
 	buffer_template() {}
 	buffer_template(T* _in_data, std::size_t _in_size)
 		: _data(_in_data), _size(_in_size) {}
@@ -324,6 +491,39 @@ public:
 	const T* end() const { return _data + size(); }
 	T* data() { return begin(); }
 	const T* data() const { return begin(); }
+
+	//! Evaluates an expression (see ladspa++/expression.h) in one loop
+	template<class E, class = typename E::expression_tag>
+	buffer_template& operator=(const E& e)
+	{
+		for(std::size_t i = 0; i < _size; ++i)
+			_data[i] = e[i];
+		return *this;
+	}
+
+	template<class E, class = typename E::expression_tag>
+	buffer_template& operator+=(const E& e)
+	{
+		for(std::size_t i = 0; i < _size; ++i)
+			_data[i] += e[i];
+		return *this;
+	}
+
+	template<class E, class = typename E::expression_tag>
+	buffer_template& operator-=(const E& e)
+	{
+		for(std::size_t i = 0; i < _size; ++i)
+			_data[i] -= e[i];
+		return *this;
+	}
+
+	template<class E, class = typename E::expression_tag>
+	buffer_template& operator*=(const E& e)
+	{
+		for(std::size_t i = 0; i < _size; ++i)
+			_data[i] *= e[i];
+		return *this;
+	}
 };
 
 //! A class that behaves like a reference to @a T.
@@ -332,10 +532,12 @@ class pointer_template
 {
 	T* _data;
 public:
+	typedef T value_type;
+
 	pointer_template() {}
 	pointer_template(T* _in_data)
 		: _data(_in_data) {}
-	pointer_template(T* _in_data, int )
+	pointer_template(T* _in_data, std::size_t )
 		: pointer_template(_in_data) {}
 
 	void assign(T* _in_data) { _data = _in_data; }
@@ -354,6 +556,131 @@ typedef pointer_template<data> pointer;
 //! Class for const single values (like out ports)
 typedef pointer_template<const data> const_pointer;
 
+/**
+ * @brief Checks whether all samples of @a buf are equal.
+ *
+ * Audio rate modulation inputs are constant most of the time, because
+ * nothing is patched into them. If they are, a plugin can run a kernel
+ * with a scalar parameter instead, e.g. compute filter coefficients once
+ * per block instead of once per sample. The check compares chunks of 32
+ * samples and stops at the first chunk that differs, so it costs a fraction
+ * of a pass for constant inputs, and next to nothing for varying ones.
+ *
+ * @param value set to the first sample
+ * @param stride if greater than 1, only every @a stride-th sample and the
+ *   last one are compared. This is cheaper, but misses changes between
+ *   the compared samples, so only use it if the input is known to be smooth.
+ * @return true iff @a buf is not empty and all compared samples are equal
+ *   (NaN samples never are, and 0 and -0 only with a @a stride)
+ */
+inline bool is_constant(const const_buffer& buf, data& value,
+	std::size_t stride = 1)
+{
+	static_assert(sizeof(data) == sizeof(std::uint32_t),
+		"is_constant() assumes 32 bit samples");
+	const data* x = buf.data();
+	const std::size_t n = buf.size();
+	if(!n)
+		return false;
+	const data v = value = x[0];
+	if(stride > 1)
+	{
+		for(std::size_t i = stride; i < n; i += stride)
+			if(x[i] != v)
+				return false;
+		return x[n - 1] == v;
+	}
+
+	// integer compares of the bits vectorize better than float compares,
+	// the only difference is that 0 and -0 count as different
+	std::uint32_t bits;
+	std::memcpy(&bits, &v, sizeof(bits));
+	constexpr std::size_t chunk = 32;
+	const std::size_t blocked = n - n % chunk;
+	for(std::size_t i = 0; i < blocked; i += chunk)
+	{
+		// no early exit inside the chunk, so it is vectorized
+		std::uint32_t differs = 0;
+		for(std::size_t j = 0; j < chunk; ++j)
+		{
+			std::uint32_t sample;
+			std::memcpy(&sample, x + i + j, sizeof(sample));
+			differs |= sample ^ bits;
+		}
+		if(differs)
+			return false;
+	}
+	for(std::size_t i = blocked; i < n; ++i)
+	{
+		std::uint32_t sample;
+		std::memcpy(&sample, x + i, sizeof(sample));
+		if(sample != bits)
+			return false;
+	}
+	return v == v;
+}
+
+/**
+ * @brief Class to access a group of @a N ports of type @a T.
+ *
+ * @a T is one of the buffer or pointer types above. The pointers of all
+ * channels are contiguous, so data() can directly be passed to routines
+ * which process all channels at once.
+ * Can be hard copied, this will be cheap.
+ */
+template<class T, std::size_t N>
+class port_group_template
+{
+public:
+	//! data or const data
+	typedef typename T::value_type data_type;
+	typedef T value_type;
+private:
+	ladspa::data* const* _channels;
+	std::size_t _sample_count;
+public:
+	//! Iterator over the channels
+	class iterator
+	{
+		const port_group_template* group;
+		std::size_t channel;
+	public:
+		iterator(const port_group_template* _group, std::size_t _channel)
+			: group(_group), channel(_channel) {}
+		T operator*() const { return (*group)[channel]; }
+		iterator& operator++() { ++channel; return *this; }
+		bool operator!=(const iterator& other) const {
+			return channel != other.channel;
+		}
+	};
+
+	port_group_template() {}
+	port_group_template(ladspa::data* const* _in_channels, std::size_t _in_size)
+		: _channels(_in_channels), _sample_count(_in_size) {}
+
+	//! number of channels
+	static constexpr std::size_t size() { return N; }
+	//! number of samples in each channel
+	std::size_t sample_count() const { return _sample_count; }
+
+	//! channel with a runtime index
+	T operator[](std::size_t channel) const {
+		return T(_channels[channel], _sample_count);
+	}
+	//! channel with a compile time index
+	template<std::size_t channel>
+	T get() const {
+		static_assert(channel < N, "Channel index out of range.");
+		return (*this)[channel];
+	}
+
+	iterator begin() const { return iterator(this, 0); }
+	iterator end() const { return iterator(this, N); }
+
+	//! contiguous array of the @a N channels' pointers
+	data_type* const* data() const { return _channels; }
+};
+
 //! A class which describes a port.
 struct port_info_t
 {
@@ -376,8 +703,21 @@ struct port_info_t
 	const char* desription; //!< A short description about what it does
 	bitmask<port_types> descriptor; //!< Information about the port type
 	range_hint_t hint; //!< Information about numeric range
+	//! Number of channels if this is a port group, otherwise 0
+	port_size_t group_size;
 	
 	constexpr bool is_final() const { return (name == nullptr); }
+	constexpr bool is_group() const { return group_size != 0; }
+	//! Number of ladspa ports that this port expands to
+	constexpr port_size_t port_count() const {
+		return is_group() ? group_size : 1;
+	}
+	
+	//! Returns a group of @a channels ports which are like this port.
+	//! The ladspa port names get numbered, like "Input 1", "Input 2", ...
+	constexpr port_info_t group(port_size_t channels) const {
+		return { name, desription, descriptor, hint, channels };
+	}
 	
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 	//! This class is used in combination with the get() functions
@@ -433,6 +773,13 @@ namespace port_info_common
 		"Output (R)", "Effect's audio output (right).",
 		port_types::output | port_types::audio };
 	
+	//! the conventional output port for the latency, in samples,
+	//! which hosts use to compensate it
+	constexpr static port_info_t latency = {
+		"latency", "Latency of the effect, in samples.",
+		port_types::output | port_types::control,
+		{port_hints::integer, 0, 0} };
+	
 	// more ports can be added on request...
 	
 	//! port marking the end, recognized via the nullptr
@@ -441,6 +788,182 @@ namespace port_info_common
 }
 
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
+namespace helpers
+{
+
+/*
+ * port layout
+ *
+ * Rows of the port info array can be groups, which expand to multiple
+ * ladspa ports. The offsets of all rows are computed once, by bisecting
+ * the rows, and are then looked up.
+ */
+
+//! number of ladspa ports in rows [lo, hi)
+constexpr port_size_t port_count_sum(const port_info_t* arr,
+	std::size_t lo, std::size_t hi)
+{
+	return (hi - lo == 0) ? 0
+		: (hi - lo == 1) ? arr[lo].port_count()
+		: port_count_sum(arr, lo, lo + (hi - lo)/2)
+			+ port_count_sum(arr, lo + (hi - lo)/2, hi);
+}
+
+template<std::size_t ...Vs>
+struct value_seq
+{
+};
+
+template<class Seq, std::size_t Offset, class Rhs>
+struct _append_shifted;
+
+template<std::size_t ...L, std::size_t Offset, std::size_t ...R>
+struct _append_shifted<value_seq<L...>, Offset, value_seq<R...>>
+{
+	using type = value_seq<L..., (R + Offset)...>;
+};
+
+//! offsets of the rows [Lo, Lo + Len), relative to row @a Lo
+template<const port_info_t* PortDesArray, std::size_t Lo, std::size_t Len>
+struct _port_offsets
+{
+	using lhs = _port_offsets<PortDesArray, Lo, Len/2>;
+	using rhs = _port_offsets<PortDesArray, Lo + Len/2, Len - Len/2>;
+	static constexpr port_size_t total = lhs::total + rhs::total;
+	using type = typename _append_shifted<typename lhs::type,
+		lhs::total, typename rhs::type>::type;
+};
+
+template<const port_info_t* PortDesArray, std::size_t Lo>
+struct _port_offsets<PortDesArray, Lo, 1>
+{
+	static constexpr port_size_t total = PortDesArray[Lo].port_count();
+	using type = value_seq<0>;
+};
+
+template<const port_info_t* PortDesArray, std::size_t Lo>
+struct _port_offsets<PortDesArray, Lo, 0>
+{
+	static constexpr port_size_t total = 0;
+	using type = value_seq<>;
+};
+
+template<class Seq, std::size_t Total>
+struct _offset_table;
+
+template<std::size_t ...Vs, std::size_t Total>
+struct _offset_table<value_seq<Vs...>, Total>
+{
+	static constexpr id_array<sizeof...(Vs) + 1> value = {{Vs..., Total}};
+};
+
+template<std::size_t ...Vs, std::size_t Total>
+constexpr id_array<sizeof...(Vs) + 1>
+	_offset_table<value_seq<Vs...>, Total>::value;
+
+//! the row in [lo, hi) of @a offsets which contains ladspa port @a port
+template<std::size_t N>
+constexpr std::size_t find_row(const id_array<N>& offsets, port_size_t port,
+	std::size_t lo, std::size_t hi)
+{
+	return (hi - lo == 1)
+		? lo
+		: (offsets.ids[lo + (hi - lo)/2] <= port)
+			? find_row(offsets, port, lo + (hi - lo)/2, hi)
+			: find_row(offsets, port, lo, lo + (hi - lo)/2);
+}
+
+//! maps the @a Rows rows of a port info array to ladspa ports and back
+template<const port_info_t* PortDesArray, std::size_t Rows>
+struct port_layout
+{
+	using offsets_t = _port_offsets<PortDesArray, 0, Rows>;
+	using table = _offset_table<typename offsets_t::type, offsets_t::total>;
+
+	//! number of ladspa ports
+	static constexpr port_size_t size = offsets_t::total;
+
+	//! ladspa port index of the first port of row @a row
+	static constexpr port_size_t offset(std::size_t row) {
+		return table::value.ids[row];
+	}
+
+	//! the row which contains ladspa port @a port
+	static constexpr std::size_t row_of(port_size_t port) {
+		return find_row(table::value, port, 0, Rows);
+	}
+};
+
+/*
+ * port names
+ */
+
+template<std::size_t N>
+struct name_buffer
+{
+	char str[N];
+};
+
+constexpr std::size_t const_strlen(const char* str)
+{
+	return (*str == 0) ? 0 : const_strlen(str + 1) + 1;
+}
+
+constexpr std::size_t count_digits(std::size_t number)
+{
+	return (number < 10) ? 1 : count_digits(number / 10) + 1;
+}
+
+constexpr std::size_t pow10(std::size_t exp)
+{
+	return (exp == 0) ? 1 : pow10(exp - 1) * 10;
+}
+
+//! char @a i of "<name> <number>"
+constexpr char numbered_char(const char* name, std::size_t len,
+	std::size_t number, std::size_t digits, std::size_t i)
+{
+	return (i < len) ? name[i]
+		: (i == len) ? ' '
+		: (i > len + digits) ? '\0'
+		: (char)('0' + (number / pow10(len + digits - i)) % 10);
+}
+
+//! name of ladspa port @a Port, numbered if it belongs to a group
+template<const port_info_t* PortDesArray, std::size_t Rows, std::size_t Port>
+class port_name_at
+{
+	using layout = port_layout<PortDesArray, Rows>;
+	static constexpr std::size_t row = layout::row_of(Port);
+	static constexpr const char* name = PortDesArray[row].name;
+	static constexpr std::size_t number = Port - layout::offset(row) + 1;
+	static constexpr std::size_t len = const_strlen(name);
+	static constexpr std::size_t digits = count_digits(number);
+	static constexpr std::size_t buffer_size
+		= PortDesArray[row].is_group() ? (len + digits + 2) : 1;
+
+	template<int ...Is>
+	static constexpr name_buffer<buffer_size> make(full_seq<Is...>)
+	{
+		return {{ numbered_char(name, len, number, digits, Is)... }};
+	}
+
+	static constexpr name_buffer<buffer_size> numbered
+		= make(seq<buffer_size>{});
+public:
+	static constexpr const char* value
+		= PortDesArray[row].is_group() ? numbered.str : name;
+};
+
+template<const port_info_t* PortDesArray, std::size_t Rows, std::size_t Port>
+constexpr name_buffer<port_name_at<PortDesArray, Rows, Port>::buffer_size>
+	port_name_at<PortDesArray, Rows, Port>::numbered;
+
+template<const port_info_t* PortDesArray, std::size_t Rows, std::size_t Port>
+constexpr const char* port_name_at<PortDesArray, Rows, Port>::value;
+
+} // namespace helpers
+
 /*
  *  Return value specialisations for port_array_t
  */
@@ -475,6 +998,30 @@ struct return_value_access_type
 	typedef base_type type;
 };
 
+/**
+ * The types of a port, only depending on the port info array.
+ *
+ * This is kept out of the port containers, whose template argument lists
+ * can get long, so each port's types are only computed once.
+ */
+template<const port_info_t* PortDesArray, std::size_t PortName>
+class port_type_at
+{
+	static constexpr auto arr_elem = PortDesArray[PortName];
+	static constexpr auto descr = arr_elem.descriptor;
+public:
+	//! data or const data
+	typedef typename return_value_access_type<data, &descr>::type
+		data_type;
+	//! buffer or pointer to @a data_type
+	typedef typename return_value_base_type<data_type, &descr>::type
+		single_type;
+	//! @a single_type, or a group of those
+	typedef typename std::conditional<arr_elem.is_group(),
+		port_group_template<single_type, arr_elem.group_size>,
+		single_type>::type type;
+};
+
 template<class PortNamesT, const port_info_t* PortDesArray>
 class port_array_t;
 
@@ -496,68 +1043,43 @@ template<class PortNamesT, const port_info_t* PortDesArray,
 	typename port_array_t<PortNamesT, PortDesArray>::port_names_t ...PortIndexes>
 class port_ptrs<port_array_t<PortNamesT, PortDesArray>, PortIndexes...>
 {
-	class type_helpers
-	{
-		template<const bitmask<port_types>* bm>
-		using t1 = typename return_value_access_type<data, bm>::type;
-		
-	public:
-		template<std::size_t PortName>
-		class type_at_port
-		{	
-			static constexpr auto arr_elem = PortDesArray[PortName];
-			static constexpr auto descr = arr_elem.descriptor;
-		public:
-			typedef t1<&descr> type; // data or const data
-		};
-
-		template<std::size_t ...Is>
-		struct _storage_t
-		{
-			typedef typename std::tuple
-				<typename type_at_port<Is>::type*...> type;
-		};
-	};
 public:
 	template<int PortName>
-	using type_at = typename type_helpers::template type_at_port<PortName>::type;
+	using type_at = typename port_type_at<PortDesArray, PortName>::data_type;
 
 private:
-	typedef typename type_helpers::template _storage_t<(int)PortIndexes...>::type
-	storage_t;
+	constexpr static std::size_t ptr_count = sizeof...(PortIndexes);
+
+	//! flat storage, the constness is added in get()
+	typedef std::array<data*, ptr_count> storage_t;
 
 	storage_t pointers; //!< valid if we are not at the end()
 			
 	typedef port_array_t<PortNamesT, PortDesArray> port_array_t_t;
 	
 	template<std::size_t id>
-	type_at<id>*& get_ptr() {
-		return std::get<helpers::id_in_list<id, (std::size_t)PortIndexes...>::value>(port_ptrs::pointers);
-	}
-	
-	template<typename port_array_t_t::port_names_t id>
-	type_at<(std::size_t)id>*& get_ptr() {
-		return get_ptr<(std::size_t)id>();
-	}
-	
-	template<std::size_t id>
-	type_at<id>& get() {
-		return *get_ptr<id>();
+	data*& get_ptr() {
+		constexpr std::size_t pos = helpers::id_in_list<id,
+			(std::size_t)PortIndexes...>::value;
+		static_assert(pos != helpers::npos,
+			"This port is not being iterated over.");
+		return pointers[pos];
 	}
 	
 public:
 	port_ptrs(const port_array_t_t& port_array_t)
-		: pointers(port_array_t.template get<PortIndexes>().begin()...) {}
+		: pointers{{port_array_t.template get_raw<PortIndexes>()...}} {}
 	port_ptrs() {}
 	
 	void operator++()
 	{
-		helpers::do_nothing(++(get_ptr<PortIndexes>())...);
+		for(data*& ptr : pointers)
+			++ptr;
 	}
 	
 	template<typename port_array_t_t::port_names_t id>
 	type_at<(std::size_t)id>& get() {
-		return get<(std::size_t)id>();
+		return *get_ptr<(std::size_t)id>();
 	}
 };
 
@@ -638,112 +1160,148 @@ class port_array_t
 private:
 	typedef port_array_t<PortNamesT, PortDesArray> m_type;
 	
-	class type_helpers
-	{
-	
-		template<const bitmask<port_types>* bm>
-		using t1 = typename return_value_access_type<data, bm>::type;
-		template<const bitmask<port_types>* bm>
-		using return_value_preparation = typename return_value_base_type<t1<bm>, bm>::type;
-	public:
-		template<std::size_t PortName>
-		class type_at_port
-		{	
-			static constexpr auto arr_elem = PortDesArray[PortName];
-			static constexpr auto descr = arr_elem.descriptor;
-		public:
-			typedef return_value_preparation<&descr> type;
-		};
-	
-		template<class T> struct _storage_t {
-			helpers::dont_instantiate_me<T> x;
-		};
-		template<int ...Is>
-		struct _storage_t<helpers::full_seq<Is...>>
-		{
-			typedef std::tuple<typename type_at_port<Is>::type...> type;
-		};
-	};
-	
+	//! number of rows in the port info array
 	constexpr static std::size_t port_size = helpers::enum_size<PortNamesT>();
+	//! number of ladspa ports, after expanding the groups
+	typedef helpers::port_layout<PortDesArray, port_size> layout;
+	constexpr static std::size_t ladspa_port_size = layout::size;
 	constexpr static const port_info_t* port_des_array = PortDesArray;
 public:
 	typedef PortNamesT port_names_t;
 	template<int PortName>
-	using type_at = typename type_helpers::template type_at_port<PortName>::type;
+	using type_at = typename port_type_at<PortDesArray, PortName>::type;
 private:
-	typedef typename type_helpers::template _storage_t<
-		typename helpers::template seq<port_size>>::type storage_t;
+	//! flat storage, indexed by the ladspa port,
+	//! the buffer types are only built in get()
+	typedef std::array<data*, ladspa_port_size> storage_t;
 private:
 	/*
 	 * data 
 	 */
-	storage_t storage;
-	int _current_sample_count;
-	
-	template<int id>
-	static void set_static(port_array_t& p, data* d) {
-		p.set_internal<id>(d);
-	}
-	
-	struct caller
-	{
-		void (&callback)(port_array_t&, data*);
-	};
+	//! the pointers and the sample count are all that run() reads
+	alignas(cache_line_size) storage_t storage;
+	sample_size_t _current_sample_count;
 	
+	//! single ports
 	template<class T>
-	static constexpr typename std::array<caller, port_size> init_callers(T)
-	{
-		static_assert(helpers::falsify<T>::value,
-			"This should not be instantiated.");
-		return {}; // constexpr function must have return value
+	static T make_port(helpers::identity<T>, data* const* first,
+		sample_size_t sample_count) {
+		return T(*first, sample_count);
 	}
-
-	template<int ...Is>
-	static constexpr typename std::array<caller, port_size> init_callers(helpers::full_seq<Is...>)
-	{
-		return {{{port_array_t::set_static<Is>}...}};
-	}
-
-	static constexpr typename std::array<caller, port_size> callers
-		= init_callers(typename helpers::seq<port_size>{});
 	
-	static constexpr bool in_range_cond(int id)
-	{
-		return id >= 0 &&
-			(std::size_t)id < helpers::enum_size<port_names_t>();
+	//! port groups
+	template<class T, std::size_t N>
+	static port_group_template<T, N> make_port(
+		helpers::identity<port_group_template<T, N>>,
+		data* const* first, sample_size_t sample_count) {
+		return port_group_template<T, N>(first, sample_count);
 	}
 	
-	template<int id>
-	void set_internal(data* d) {
-		assert(in_range_cond(id));
-		std::get<id>(storage).assign(d);
-	}
 public:
 
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 	//! Intended for internal use only
-	void set_caller(int id, data* d) {
-		callers[id].callback(*this, d);
+	void connect(port_size_t port, data* d) {
+		assert(port < ladspa_port_size);
+		storage[port] = d;
 	}
 	//! Intended for internal use only
 	void set_current_sample_count(sample_size_t s) { 
 		_current_sample_count = s;
 	}
+	//! Intended for internal use only
+	template<port_names_t id>
+	data* get_raw() const {
+		static_assert(!PortDesArray[(std::size_t)id].is_group(),
+			"Port groups can not be iterated over sample-wise, "
+			"iterate over their channels instead.");
+		return storage[layout::offset((std::size_t)id)];
+	}
+	//! Intended for internal use only
+	data* raw_port(port_size_t port) const { return storage[port]; }
+	//! Intended for internal use only
+	sample_size_t sample_count() const { return _current_sample_count; }
+	//! true iff ladspa port @a port is an audio port
+	static constexpr bool is_audio(port_size_t port) {
+		return PortDesArray[layout::row_of(port)].descriptor
+			.is(port_types::audio);
+	}
+	//! number of ladspa ports
+	static constexpr port_size_t size() { return ladspa_port_size; }
+	//! true iff ladspa port @a port is an audio output
+	static constexpr bool is_audio_output(port_size_t port) {
+		return PortDesArray[layout::row_of(port)].descriptor
+				.is(port_types::output)
+			&& PortDesArray[layout::row_of(port)].descriptor
+				.is(port_types::audio);
+	}
+	//! number of audio output ports in [lo, hi), bisecting the range
+	static constexpr port_size_t audio_outputs(port_size_t lo = 0,
+		port_size_t hi = ladspa_port_size) {
+		return (hi - lo == 0) ? 0
+			: (hi - lo == 1) ? is_audio_output(lo)
+			: audio_outputs(lo, lo + (hi - lo)/2)
+				+ audio_outputs(lo + (hi - lo)/2, hi);
+	}
+	//! ladspa port of the @a n-th audio output port in [lo, hi)
+	static constexpr port_size_t audio_output(port_size_t n,
+		port_size_t lo = 0, port_size_t hi = ladspa_port_size) {
+		return (hi - lo == 1) ? lo
+			: (n < audio_outputs(lo, lo + (hi - lo)/2))
+			? audio_output(n, lo, lo + (hi - lo)/2)
+			: audio_output(n - audio_outputs(lo, lo + (hi - lo)/2),
+				lo + (hi - lo)/2, hi);
+	}
 #endif /* DOXYGEN_SHOULD_SKIP_THIS */
 
+	//! returns a buffer or pointer,
+	//! or, for port groups, a port_group_template
 	template<std::size_t id>
 	type_at<id> get() const {
-		type_at<id> ret_val = std::get<id>(storage);
-		// buffer size is usually not set - set it
-		ret_val.set_size(_current_sample_count);
-		return ret_val;
+		constexpr port_size_t offset = layout::offset(id);
+		return make_port(helpers::identity<type_at<id>>(),
+			&storage[offset], _current_sample_count);
 	}
 	template<port_names_t id>
 	type_at<(std::size_t)id> get() const {
 		return get<(std::size_t)id>();
 	}
-	
+
+	//! checks whether the audio input @a id is constant in this block,
+	//! see ladspa::is_constant()
+	template<port_names_t id>
+	bool is_constant(data& value, std::size_t stride = 1) const {
+		static_assert(PortDesArray[(std::size_t)id].descriptor
+				.is(port_types::audio)
+			&& PortDesArray[(std::size_t)id].descriptor
+				.is(port_types::input),
+			"Only audio inputs can be checked for being constant.");
+		return ladspa::is_constant(const_buffer(get_raw<id>(),
+			_current_sample_count), value, stride);
+	}
+
+	/**
+	 * @brief Runs the kernel that fits the audio input @a id.
+	 *
+	 * If the input is constant in this block, @a constant is called with
+	 * its value, otherwise, @a varying is called with its buffer:
+	 * @code
+	 * ports.dispatch_constant<cutoff>(
+	 * 	[&](data f) { filter.set(lowpass(f)); filter.process(in, out); },
+	 * 	[&](const_buffer f) { ... per sample ... });
+	 * @endcode
+	 * @param stride see ladspa::is_constant()
+	 */
+	template<port_names_t id, class Constant, class Varying>
+	void dispatch_constant(Constant&& constant, Varying&& varying,
+		std::size_t stride = 1) const {
+		data value;
+		if(is_constant<id>(value, stride))
+			constant(value);
+		else
+			varying(const_buffer(get_raw<id>(), _current_sample_count));
+	}
+
 	//! lets you choose which buffers you want to iterate over
 	template<port_names_t ...port_ids>
 	samples_container<m_type, port_ids...> buffers() {
@@ -764,11 +1322,6 @@ public:
 	}
 };
 
-template<class PortNamesT, const port_info_t* port_des_array>
-constexpr typename std::array<typename port_array_t<PortNamesT, port_des_array>::caller, 
-	port_array_t<PortNamesT, port_des_array>::port_size>
-	port_array_t<PortNamesT, port_des_array>::callers;
-
 //! A class which the programmer fills in to describe her/his plugin
 struct info_t
 {
@@ -783,12 +1336,594 @@ struct info_t
 	void * implementation_data;
 };
 
-//! returns size of the port array
+//! returns the number of ladspa ports in the port array,
+//! where each group counts as its number of channels
+//! @note this recurses once per port, prefer the overload for arrays
 static constexpr port_size_t get_port_size(const ladspa::port_info_t* arr) {
-	return arr->is_final() ? 0 : get_port_size(arr + 1) + 1;
+	return arr->is_final() ? 0 : get_port_size(arr + 1) + arr->port_count();
 }
 
+//! returns the number of ladspa ports in the port array,
+//! where each group counts as its number of channels
+template<std::size_t N>
+static constexpr port_size_t get_port_size(const ladspa::port_info_t (&arr)[N]) {
+	return helpers::port_count_sum(arr, 0, N - 1);
+}
+
+//! What the output guard does with NaN and Inf samples
+enum class guard_mode
+{
+	off, //!< no checks at all (the default)
+	zero, //!< replace them by 0
+	hold //!< replace them by the last finite sample of the same port
+};
+
+/**
+ * @brief Options for the output guard.
+ *
+ * After each run(), the guard scans all audio outputs. It replaces NaN and
+ * Inf samples as given by @a mode, and flushes denormals to 0. After
+ * @a reset_after faulty blocks in a row, it resets the plugin by calling
+ * its deactivate() and activate() functions, if it has them.
+ *
+ * To enable it, declare in your plugin class:
+ * @code
+ * static constexpr output_guard_t output_guard = { guard_mode::zero, 4 };
+ * @endcode
+ * Scanning costs about one pass over the output buffers per block.
+ */
+struct output_guard_t
+{
+	guard_mode mode;
+	//! number of faulty blocks in a row before a reset, 0 for never
+	unsigned reset_after;
+};
+
+//! Counters of the output guard, see output_guard_stats()
+struct guard_stats
+{
+	std::uint64_t faulty_blocks; //!< blocks with NaN or Inf samples
+	std::uint64_t bad_samples; //!< replaced NaN and Inf samples
+	std::uint64_t denormals; //!< samples flushed to 0
+	std::uint64_t resets; //!< resets after repeated faults
+};
+
+/**
+ * @brief Declares a control port which selects among run() variants.
+ *
+ * Bypass switches, filter orders or mode selectors should not be tested
+ * in the inner loops. Instead, declare in your plugin class
+ * @code
+ * static constexpr variant_port_t<port_names> variant_port
+ * 	= { port_names::order, 256 };
+ * template<int Order>
+ * void run(port_array_t<port_names, port_info>& ports) { ... }
+ * @endcode
+ * The port must be a control input with the toggled hint, which selects
+ * run<0>() or run<1>(), or with the integer hint and both bounds, which
+ * selects run<lower_bound>() up to run<upper_bound>(). The table of all
+ * variants is built at compile time, and the variant is picked once per
+ * block, by the port value (rounded and clamped to the bounds).
+ *
+ * When the variant changes, the audio outputs are crossfaded from the old
+ * to the new variant over @a crossfade samples, or switched at once if it
+ * is 0. During the fade, both variants run on the same input, the old one
+ * first, in chunks of up to 64 samples. State they share is advanced
+ * twice, so keep separate state per variant if that matters.
+ */
+template<class PortNames>
+struct variant_port_t
+{
+	PortNames port;
+	//! samples to crossfade over, 0 to switch at once
+	sample_size_t crossfade;
+};
+
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
+namespace helpers
+{
+
+//! checks whether class @a T has a static member output_guard
+template <typename T>
+class has_output_guard
+{
+	template <typename U>
+	static int32_t sfinae( decltype( &U::output_guard ) );
+	template <typename U>
+	static int8_t sfinae( ... );
+
+public:
+	static constexpr bool value =
+		sizeof( sfinae<T>( nullptr ) ) == sizeof( int32_t );
+};
+
+template<class Plugin, bool = has_output_guard<Plugin>::value>
+struct guard_options
+{
+	static constexpr output_guard_t value = { guard_mode::off, 0 };
+};
+
+template<class Plugin>
+struct guard_options<Plugin, true>
+{
+	static constexpr output_guard_t value = Plugin::output_guard;
+};
+
+static_assert(sizeof(data) == sizeof(std::uint32_t),
+	"The output guard expects 32 bit floats.");
+constexpr std::uint32_t exponent_bits = 0x7f800000u;
+constexpr std::uint32_t mantissa_bits = 0x007fffffu;
+
+//! Returns true iff @a x contains NaN, Inf or denormals
+//! @note this loop has no branches and no compares, so it is vectorized
+inline bool scan_samples(const data* x, std::size_t n)
+{
+	std::uint32_t found = 0;
+	for(std::size_t i = 0; i < n; ++i)
+	{
+		std::uint32_t bits;
+		std::memcpy(&bits, x + i, sizeof(bits));
+		const std::uint32_t exponent = bits & exponent_bits;
+		const std::uint32_t mantissa = bits & mantissa_bits;
+		// the top bit is set iff the exponent is all ones (NaN, Inf),
+		// or iff it is zero and the mantissa is not (denormals)
+		found |= (exponent + 0x00800000u)
+			| ((exponent - 1) & (0u - mantissa));
+	}
+	return found >> 31;
+}
+
+//! Replaces NaN and Inf by @a last and denormals by 0. If @a hold is
+//! true, @a last follows the finite samples. Returns the number of NaN
+//! and Inf samples.
+inline std::size_t repair_samples(data* x, std::size_t n, data& last,
+	bool hold, std::uint64_t& denormals)
+{
+	std::size_t bad = 0;
+	for(std::size_t i = 0; i < n; ++i)
+	{
+		std::uint32_t bits;
+		std::memcpy(&bits, x + i, sizeof(bits));
+		const std::uint32_t exponent = bits & exponent_bits;
+		if(exponent == exponent_bits)
+		{
+			x[i] = last;
+			++bad;
+		}
+		else
+		{
+			if(!exponent && (bits & mantissa_bits))
+			{
+				x[i] = 0;
+				++denormals;
+			}
+			if(hold)
+				last = x[i];
+		}
+	}
+	return bad;
+}
+
+//! the ladspa ports of all audio outputs of @a PortArray
+template<class PortArray,
+	class Seq = seq<PortArray::audio_outputs()>>
+struct audio_output_table;
+
+template<class PortArray, int ...Is>
+struct audio_output_table<PortArray, full_seq<Is...>>
+{
+	static constexpr port_size_t size = sizeof...(Is);
+	static constexpr port_size_t ports[size ? size : 1]
+		= { PortArray::audio_output(Is)... };
+};
+
+template<class PortArray, int ...Is>
+constexpr port_size_t
+	audio_output_table<PortArray, full_seq<Is...>>::ports[];
+
+/**
+ * The output guard of a plugin_holder_t.
+ *
+ * The counters are atomic, so they can be read by a monitoring thread
+ * while the plugin runs.
+ */
+template<guard_mode Mode, unsigned ResetAfter, class PortArray>
+class output_guard
+{
+	typedef audio_output_table<PortArray> table;
+	static constexpr port_size_t outputs = table::size;
+
+	std::atomic<std::uint64_t> _faulty_blocks{0}, _bad_samples{0},
+		_denormals{0}, _resets{0};
+	unsigned _faults_in_row = 0;
+	//! last finite sample of each audio output, for guard_mode::hold
+	data _last[outputs ? outputs : 1] = {};
+
+	static void add(std::atomic<std::uint64_t>& counter, std::uint64_t n) {
+		counter.store(counter.load(std::memory_order_relaxed) + n,
+			std::memory_order_relaxed);
+	}
+
+	template<class Holder>
+	void repair(Holder& holder, const PortArray& ports)
+	{
+		const sample_size_t n = ports.sample_count();
+		std::uint64_t bad = 0, denormals = 0;
+		for(port_size_t k = 0; k < outputs; ++k)
+			bad += repair_samples(ports.raw_port(table::ports[k]), n,
+				_last[k], Mode == guard_mode::hold, denormals);
+		add(_denormals, denormals);
+		if(!bad)
+		{
+			_faults_in_row = 0;
+			return;
+		}
+		add(_bad_samples, bad);
+		add(_faulty_blocks, 1);
+		if(ResetAfter && ++_faults_in_row >= ResetAfter)
+		{
+			holder.deactivate();
+			holder.activate();
+			add(_resets, 1);
+			_faults_in_row = 0;
+			for(data& d : _last)
+				d = 0;
+		}
+	}
+
+public:
+	template<class Holder>
+	void check(Holder& holder, const PortArray& ports)
+	{
+		const sample_size_t n = ports.sample_count();
+		bool found = false;
+		for(port_size_t k = 0; k < outputs; ++k)
+			found = scan_samples(ports.raw_port(table::ports[k]), n)
+				|| found;
+		if(found)
+			repair(holder, ports);
+		else
+		{
+			_faults_in_row = 0;
+			if(Mode == guard_mode::hold && n)
+			for(port_size_t k = 0; k < outputs; ++k)
+				_last[k] = ports.raw_port(table::ports[k])[n - 1];
+		}
+	}
+
+	guard_stats stats() const
+	{
+		return { _faulty_blocks.load(std::memory_order_relaxed),
+			_bad_samples.load(std::memory_order_relaxed),
+			_denormals.load(std::memory_order_relaxed),
+			_resets.load(std::memory_order_relaxed) };
+	}
+};
+
+//! no guard, no checks
+template<unsigned ResetAfter, class PortArray>
+class output_guard<guard_mode::off, ResetAfter, PortArray>
+{
+public:
+	template<class Holder>
+	void check(Holder&, const PortArray&) {}
+	guard_stats stats() const { return guard_stats(); }
+};
+
+template<class Plugin>
+using output_guard_for = output_guard<guard_options<Plugin>::value.mode,
+	guard_options<Plugin>::value.reset_after,
+	port_array_t<typename Plugin::port_names, Plugin::port_info>>;
+
+//! checks whether class @a T has a static member variant_port
+template <typename T>
+class has_variant_port
+{
+	template <typename U>
+	static int32_t sfinae( decltype( &U::variant_port ) );
+	template <typename U>
+	static int8_t sfinae( ... );
+
+public:
+	static constexpr bool value =
+		sizeof( sfinae<T>( nullptr ) ) == sizeof( int32_t );
+};
+
+//! which ladspa ports of @a PortArray are audio ports
+template<class PortArray, class Seq = seq<PortArray::size()>>
+struct audio_port_table;
+
+template<class PortArray, int ...Is>
+struct audio_port_table<PortArray, full_seq<Is...>>
+{
+	static constexpr bool is_audio[sizeof...(Is) ? sizeof...(Is) : 1]
+		= { PortArray::is_audio(Is)... };
+};
+
+template<class PortArray, int ...Is>
+constexpr bool audio_port_table<PortArray, full_seq<Is...>>::is_audio[];
+
+//! the range of run() variants of @a Plugin, from the port's hints
+template<class Plugin>
+struct variant_range
+{
+	typedef typename Plugin::port_names port_names;
+	static constexpr port_names port = Plugin::variant_port.port;
+	static constexpr port_info_t info = Plugin::port_info[(std::size_t)port];
+	static constexpr bool toggled
+		= info.hint.descriptor.is(port_hints::toggled);
+	static constexpr int lo = toggled ? 0 : (int)info.hint.lower_bound;
+	static constexpr int hi = toggled ? 1 : (int)info.hint.upper_bound;
+	static constexpr sample_size_t crossfade = Plugin::variant_port.crossfade;
+
+	static_assert(info.descriptor.is(port_types::input)
+		&& info.descriptor.is(port_types::control) && !info.is_group(),
+		"The variant port must be a single control input.");
+	static_assert(toggled || (info.hint.descriptor.is(port_hints::integer)
+		&& info.hint.descriptor.is(port_hints::bounded_below)
+		&& info.hint.descriptor.is(port_hints::bounded_above)),
+		"The variant port needs the toggled hint, or the integer hint "
+		"and both bounds.");
+	static_assert(lo <= hi && hi - lo < 64,
+		"The variant port allows too many variants.");
+
+	//! the index of the variant for the port value @a v
+	static std::size_t select(data v)
+	{
+		if(toggled)
+			return v > 0;
+		// the negated compares also catch NaN
+		const data rounded = std::floor(v + 0.5f);
+		return !(rounded > lo) ? 0
+			: !(rounded < hi) ? hi - lo
+			: (std::size_t)((int)rounded - lo);
+	}
+};
+
+//! all run() variants of @a Plugin
+template<class Plugin, class PortArray, class Range = variant_range<Plugin>,
+	class Seq = seq<Range::hi - Range::lo + 1>>
+struct variant_table;
+
+template<class Plugin, class PortArray, class Range, int ...Is>
+struct variant_table<Plugin, PortArray, Range, full_seq<Is...>>
+{
+	typedef void (Plugin::*run_t)(PortArray&);
+	static constexpr run_t runs[sizeof...(Is)]
+		= { &Plugin::template run<Range::lo + Is>... };
+};
+
+template<class Plugin, class PortArray, class Range, int ...Is>
+constexpr typename variant_table<Plugin, PortArray, Range,
+	full_seq<Is...>>::run_t
+	variant_table<Plugin, PortArray, Range, full_seq<Is...>>::runs[];
+
+/**
+ * Calls the run() function of a plugin_holder_t's plugin.
+ *
+ * If the plugin declares a variant_port, this picks the variant, and
+ * crossfades when it changes.
+ */
+template<class Plugin, class PortArray, sample_size_t Crossfade>
+class variant_runner
+{
+	typedef variant_range<Plugin> range;
+	typedef variant_table<Plugin, PortArray> table;
+	typedef audio_output_table<PortArray> outputs;
+	typedef audio_port_table<PortArray> audio;
+	static constexpr std::size_t chunk = 64;
+
+	std::size_t _current = 0, _from = 0;
+	//! samples of the current fade done, Crossfade if none is running
+	sample_size_t _faded = Crossfade;
+	bool _started = false;
+	//! outputs of the old variant during a fade
+	data _scratch[outputs::size ? outputs::size : 1][chunk];
+
+	//! moves all audio ports to the samples [@a offset, @a offset + @a n)
+	//! of the block at @a ports
+	static void shift(PortArray& ports, data* const* block,
+		sample_size_t offset, sample_size_t n)
+	{
+		for(port_size_t p = 0; p < PortArray::size(); ++p)
+			if(audio::is_audio[p])
+				ports.connect(p, block[p] + offset);
+		ports.set_current_sample_count(n);
+	}
+
+	//! runs the fade on the samples of the block from @a first on,
+	//! returns where it ended
+	sample_size_t fade(Plugin& plugin, PortArray& ports,
+		data* const* block, sample_size_t first, sample_size_t n)
+	{
+		sample_size_t i = first;
+		while(i < n && _faded < Crossfade)
+		{
+			sample_size_t m = n - i;
+			m = (m < chunk) ? m : chunk;
+			m = (m < Crossfade - _faded) ? m : Crossfade - _faded;
+			shift(ports, block, i, m);
+			for(port_size_t k = 0; k < outputs::size; ++k)
+				ports.connect(outputs::ports[k], _scratch[k]);
+			(plugin.*table::runs[_from])(ports);
+			for(port_size_t k = 0; k < outputs::size; ++k)
+				ports.connect(outputs::ports[k],
+					block[outputs::ports[k]] + i);
+			(plugin.*table::runs[_current])(ports);
+
+			const data step = 1.0f / Crossfade;
+			for(port_size_t k = 0; k < outputs::size; ++k)
+			{
+				data* out = block[outputs::ports[k]] + i;
+				const data* old = _scratch[k];
+				for(sample_size_t j = 0; j < m; ++j)
+					out[j] = old[j] + (out[j] - old[j])
+						* ((_faded + j + 1) * step);
+			}
+			i += m;
+			_faded += m;
+		}
+		return i;
+	}
+
+public:
+	void run(Plugin& plugin, PortArray& ports)
+	{
+		const std::size_t next = range::select(
+			ports.template get<range::port>());
+		// no fade before the first block
+		if(!Crossfade || !_started)
+			_current = next;
+		_started = true;
+
+		if(_faded == Crossfade && next == _current)
+		{
+			(plugin.*table::runs[_current])(ports);
+			return;
+		}
+
+		const sample_size_t n = ports.sample_count();
+		data* block[PortArray::size() ? PortArray::size() : 1];
+		for(port_size_t p = 0; p < PortArray::size(); ++p)
+			block[p] = ports.raw_port(p);
+		sample_size_t done = 0;
+		while(done < n)
+		{
+			// a new selection waits until the running fade is done,
+			// dropping its old variant earlier would make the output jump
+			if(_faded == Crossfade)
+			{
+				if(next == _current)
+					break;
+				_from = _current;
+				_current = next;
+				_faded = 0;
+			}
+			done = fade(plugin, ports, block, done, n);
+		}
+		if(done < n)
+		{
+			shift(ports, block, done, n - done);
+			(plugin.*table::runs[_current])(ports);
+		}
+		shift(ports, block, 0, n);
+	}
+};
+
+//! a plugin without variants
+template<class Plugin, class PortArray>
+class variant_runner<Plugin, PortArray, sample_size_t(-1)>
+{
+public:
+	void run(Plugin& plugin, PortArray& ports) { plugin.run(ports); }
+};
+
+template<class Plugin, bool = has_variant_port<Plugin>::value>
+struct variant_crossfade
+{
+	static constexpr sample_size_t value = sample_size_t(-1);
+};
+
+template<class Plugin>
+struct variant_crossfade<Plugin, true>
+{
+	static constexpr sample_size_t value = Plugin::variant_port.crossfade;
+};
+
+template<class Plugin>
+using variant_runner_for = variant_runner<Plugin,
+	port_array_t<typename Plugin::port_names, Plugin::port_info>,
+	variant_crossfade<Plugin>::value>;
+
+//! checks whether class @a T has a static member stateless
+template <typename T>
+class has_stateless
+{
+	template <typename U>
+	static int32_t sfinae( decltype( &U::stateless ) );
+	template <typename U>
+	static int8_t sfinae( ... );
+
+public:
+	static constexpr bool value =
+		sizeof( sfinae<T>( nullptr ) ) == sizeof( int32_t );
+};
+
+//! true iff one of the rows [lo, hi) of @a arr is a control output
+constexpr bool has_control_output(const port_info_t* arr,
+	std::size_t lo, std::size_t hi)
+{
+	return (hi - lo == 0) ? false
+		: (hi - lo == 1) ? (arr[lo].descriptor.is(port_types::output)
+			&& arr[lo].descriptor.is(port_types::control))
+		: has_control_output(arr, lo, lo + (hi - lo)/2)
+			|| has_control_output(arr, lo + (hi - lo)/2, hi);
+}
+
+//! checks whether @a Plugin declares itself stateless,
+//! and verifies what can be verified at compile time
+template<class Plugin, bool = has_stateless<Plugin>::value>
+struct is_stateless : std::false_type {};
+
+template<class Plugin>
+struct is_stateless<Plugin, true>
+	: std::integral_constant<bool, Plugin::stateless>
+{
+	static_assert(!Plugin::stateless || std::is_empty<Plugin>::value,
+		"Stateless plugins can not have non-static data members.");
+	static_assert(!Plugin::stateless || !has_control_output(
+		Plugin::port_info, 0,
+		std::extent<decltype(Plugin::port_info)>::value - 1),
+		"Stateless plugins can not have control outputs, since the "
+		"chunks of a block would all write them.");
+	static_assert(!Plugin::stateless || !has_variant_port<Plugin>::value,
+		"Stateless plugins can not have a variant port.");
+};
+
+//! runs stateless plugins, defined in ladspa++/stateless.h, which
+//! plugins declaring themselves stateless must include
+template<class Plugin, class PortArray>
+class stateless_runner;
+
+template<class Plugin>
+using runner_for = typename std::conditional<is_stateless<Plugin>::value,
+	stateless_runner<Plugin,
+		port_array_t<typename Plugin::port_names, Plugin::port_info>>,
+	variant_runner_for<Plugin>>::type;
+
+//! the state of a plugin_holder_t besides the ports and the plugin
+template<class Plugin>
+struct holder_tail : output_guard_for<Plugin>, runner_for<Plugin> {};
+
+/**
+ * The plugin of a plugin_holder_t, followed by the holder's own state
+ * @a Tail. A tail without data members is a base, so it takes no space.
+ */
+template<class Plugin, class Tail, bool = std::is_empty<Tail>::value>
+struct plugin_and_tail : Tail
+{
+	Plugin plugin;
+
+	plugin_and_tail() {}
+	explicit plugin_and_tail(sample_rate_t rate) : plugin(rate) {}
+	Tail& tail() { return *this; }
+	const Tail& tail() const { return *this; }
+};
+
+template<class Plugin, class Tail>
+struct plugin_and_tail<Plugin, Tail, false>
+{
+	Plugin plugin;
+	Tail _tail;
+
+	plugin_and_tail() {}
+	explicit plugin_and_tail(sample_rate_t rate) : plugin(rate) {}
+	Tail& tail() { return _tail; }
+	const Tail& tail() const { return _tail; }
+};
+
+}
+
 /**
  * @brief The direct holder for the plugin class
  *
@@ -801,18 +1936,26 @@ static constexpr port_size_t get_port_size(const ladspa::port_info_t* arr) {
 template<class Plugin>
 class plugin_holder_t
 {
+public:
 	typedef port_array_t<typename Plugin::port_names,
 		Plugin::port_info> _port_array_t;
-	
+private:
+	// the ports come first, and they are cache line aligned,
+	// so the plugin's first members start on a fresh cache line.
+	// the state of the output guard and of the variant crossfades is
+	// rarely touched, so it goes behind the plugin.
 	_port_array_t _ports;
-	Plugin plugin;
+	helpers::plugin_and_tail<Plugin, helpers::holder_tail<Plugin>> _state;
+#ifdef LADSPAPP_TRACE
+	std::uint32_t _trace_id = trace::recorder::instance().next_instance();
+#endif
 
 public:
 	template<class _Plugin, helpers::en_if_has<
 		_Plugin, helpers::has_ctor_1_args>* = nullptr>
 	plugin_holder_t(helpers::identity<_Plugin>,
 		sample_rate_t _sample_rate
-	) : plugin(_sample_rate) {}
+	) : _state(_sample_rate) {}
 	
 	template<class _Plugin, helpers::en_if_doesnt_have<
 		_Plugin, helpers::has_ctor_1_args>* = nullptr>
@@ -822,15 +1965,78 @@ public:
 	
 	void run(sample_size_t _sample_count) {
 		_ports.set_current_sample_count(_sample_count);
-		plugin.run(_ports);
+		_state.tail().run(_state.plugin, _ports);
+		_state.tail().check(*this, _ports);
 	}
+
+	guard_stats stats() const { return _state.tail().stats(); }
+	
+	template<class _Plugin = Plugin, helpers::en_if_has<
+		_Plugin, helpers::has_activate>* = nullptr>
+	void activate() { _state.plugin.activate(); }
+	
+	template<class _Plugin = Plugin, helpers::en_if_doesnt_have<
+		_Plugin, helpers::has_activate>* = nullptr>
+	void activate() {}
+	
+	template<class _Plugin = Plugin, helpers::en_if_has<
+		_Plugin, helpers::has_deactivate>* = nullptr>
+	void deactivate() { _state.plugin.deactivate(); }
+	
+	template<class _Plugin = Plugin, helpers::en_if_doesnt_have<
+		_Plugin, helpers::has_deactivate>* = nullptr>
+	void deactivate() {}
 	
-	void connect_port(int _port, data* d) {
-		_ports.set_caller(_port, d);
+	void connect_port(port_size_t _port, data* d) {
+		_ports.connect(_port, d);
 	}
+
+#ifdef LADSPAPP_TRACE
+	std::uint32_t trace_id() const { return _trace_id; }
+#endif
 };
 #endif /* DOXYGEN_SHOULD_SKIP_THIS */
 
+/**
+ * @brief Memory footprint of one instance of @a Plugin.
+ *
+ * All values are compile time constants, so you can guard them, e.g.
+ * @code
+ * static_assert(footprint<my_plugin>::port_cache_lines == 1,
+ * 	"The ports should fit into one cache line.");
+ * @endcode
+ */
+template<class Plugin>
+struct footprint
+{
+	typedef typename plugin_holder_t<Plugin>::_port_array_t port_array_type;
+
+	//! bytes of the port pointers and the sample count
+	static constexpr std::size_t port_bytes = sizeof(port_array_type);
+	//! bytes of the plugin class itself
+	static constexpr std::size_t plugin_bytes = sizeof(Plugin);
+	//! bytes allocated per instance
+	static constexpr std::size_t instance_bytes
+		= sizeof(plugin_holder_t<Plugin>);
+	//! cache lines that connecting ports and starting run() touch
+	static constexpr std::size_t port_cache_lines
+		= (port_bytes + cache_line_size - 1) / cache_line_size;
+	static constexpr std::size_t instance_cache_lines
+		= (instance_bytes + cache_line_size - 1) / cache_line_size;
+};
+
+/**
+ * @brief Returns the counters of the output guard of an instance.
+ *
+ * Can be called from any thread.
+ * @param instance An instance of @a Plugin, as returned by instantiate()
+ */
+template<class Plugin>
+guard_stats output_guard_stats(LADSPA_Handle instance)
+{
+	return static_cast<const plugin_holder_t<Plugin>*>(instance)->stats();
+}
+
 /**
  * @brief A class that sets up everything for the C ladpsa side.
  * 
@@ -847,16 +2053,36 @@ class builder
 	 */
 	static constexpr const info_t& descriptor = Plugin::info;
 	static constexpr const port_info_t* port_info = Plugin::port_info;
-	static constexpr port_size_t port_size = get_port_size(port_info);
+	//! number of rows in the port info array, i.e. without groups expanded
+	static constexpr std::size_t port_rows
+		= std::extent<decltype(Plugin::port_info)>::value - 1;
+	//! number of ladspa ports, i.e. with groups expanded
+	static constexpr port_size_t port_size
+		= get_port_size<port_rows + 1>(Plugin::port_info);
+	static_assert(port_info[port_rows].is_final(),
+		"The port_info array must end with the final port.");
+	static_assert(port_rows
+		== helpers::enum_size<typename Plugin::port_names>(),
+		"The port_names enum does not match the port_info array.");
 	
 	/*
-	 * This shifts the arrays
+	 * This shifts the arrays (and expands the groups)
 	 */
 	template<port_info_t::type PT, int N, class T, int... Is>
 	static constexpr auto _get_elem(helpers::full_seq<Is...>, T* lhs)
 	-> std::array<decltype(lhs[0].get(port_info_t::type_id<PT>())), N>
 	{
-		return {{lhs[Is].get(port_info_t::type_id<PT>())...}};
+		return {{lhs[helpers::port_layout<Plugin::port_info, port_rows>
+			::row_of(Is)].get(port_info_t::type_id<PT>())...}};
+	}
+	
+	//! names need to be numbered for groups
+	template<int N, class T, int... Is>
+	static constexpr auto _get_elem(helpers::full_seq<Is...>, T*)
+	-> std::array<const char*, N>
+	{
+		return {{helpers::port_name_at<Plugin::port_info,
+			port_rows, Is>::value...}};
 	}
 
 	template<port_info_t::type PT, int N, class T>
@@ -866,19 +2092,52 @@ class builder
 		return _get_elem<PT, N>(helpers::seq<N>{}, lhs);
 	}
 	
+	template<int N, class T>
+	static constexpr auto get_names(T* lhs)
+	-> decltype( _get_elem<N>(helpers::seq<N>{}, lhs) )
+	{
+		return _get_elem<N>(helpers::seq<N>{}, lhs);
+	}
+	
 	/*
 	 * These functions are the ladspa callbacks
 	 */
 
+#ifdef LADSPAPP_TRACE
+	//! a copy, so that tracing does not odr-use Plugin::info
+	static constexpr unsigned long trace_unique_id = descriptor.unique_id;
+	static std::uint32_t trace_id(LADSPA_Handle _instance) {
+		return static_cast<_plugin_holder_t*>(_instance)->trace_id();
+	}
+#endif
+
 	template<class _Plugin>
 	static LADSPA_Handle _instantiate(
 		const struct _LADSPA_Descriptor * d, sample_rate_t s) {
-		//return new _Plugin;
-		return new _plugin_holder_t(helpers::identity<Plugin>(), s);
+#ifdef LADSPAPP_TRACE
+		trace::scope trace_scope(trace::event_type::instantiate,
+			trace_unique_id, 0, s);
+#endif
+		// plain new does not respect the cache line alignment in C++11
+		void* mem = nullptr;
+		if(posix_memalign(&mem, alignof(_plugin_holder_t),
+			sizeof(_plugin_holder_t)))
+			return nullptr;
+		_plugin_holder_t* res = new (mem) _plugin_holder_t(
+			helpers::identity<Plugin>(), s);
+#ifdef LADSPAPP_TRACE
+		trace_scope.set_instance(res->trace_id());
+#endif
+		return res;
 	}
 	
 	static void _cleanup(LADSPA_Handle _instance) {
-		delete static_cast<_plugin_holder_t*>(_instance);
+#ifdef LADSPAPP_TRACE
+		trace::scope trace_scope(trace::event_type::cleanup,
+			trace_unique_id, trace_id(_instance), 0);
+#endif
+		static_cast<_plugin_holder_t*>(_instance)->~_plugin_holder_t();
+		std::free(_instance);
 	}
 	
 	static void 
@@ -886,10 +2145,12 @@ class builder
 		port_size_t _port,
 		data * _data_location)
 	{
+#ifdef LADSPAPP_TRACE
+		trace::scope trace_scope(trace::event_type::connect_port,
+			trace_unique_id, trace_id(_instance), _port);
+#endif
 		static_cast<_plugin_holder_t*>(_instance)->
 			connect_port(_port, _data_location);
-		//static_cast<_plugin_holder_t*>(_instance)->
-		//	_ports.set_caller(_port, _data_location);
 	}
 	
 /*	template<int i>
@@ -898,7 +2159,26 @@ class builder
 		constexpr static bool value = port_info[i].descriptor.is(port_types::audio);
 	};*/
 	
-	//void _activate(LADSPA_Handle Instance);
+	//! only passed to ladspa if the plugin has an activate() function
+	static void _activate(LADSPA_Handle _instance)
+	{
+#ifdef LADSPAPP_TRACE
+		trace::scope trace_scope(trace::event_type::activate,
+			trace_unique_id, trace_id(_instance), 0);
+#endif
+		static_cast<_plugin_holder_t*>(_instance)->activate();
+	}
+	
+	//! only passed to ladspa if the plugin has a deactivate() function
+	static void _deactivate(LADSPA_Handle _instance)
+	{
+#ifdef LADSPAPP_TRACE
+		trace::scope trace_scope(trace::event_type::deactivate,
+			trace_unique_id, trace_id(_instance), 0);
+#endif
+		static_cast<_plugin_holder_t*>(_instance)->deactivate();
+	}
+	
 	static void _run(LADSPA_Handle _instance,
 		sample_size_t _sample_count)
 	{
@@ -909,6 +2189,10 @@ class builder
 	//	_run_with_seq(_instance, _sample_count, helpers::gen_seq<port_size>{});
 	//	instance->run(ports);
 		
+#ifdef LADSPAPP_TRACE
+		trace::scope trace_scope(trace::event_type::run,
+			trace_unique_id, trace_id(_instance), _sample_count);
+#endif
 		static_cast<_plugin_holder_t*>(_instance)->run(_sample_count);
 	}
 	
@@ -917,7 +2201,7 @@ class builder
 		= get_elem<port_info_t::type::descriptor, port_size>(port_info);
 	static constexpr std::array<const char*, port_size>
 		port_names
-		= get_elem<port_info_t::type::name, port_size>(port_info);
+		= get_names<port_size>(port_info);
 	static constexpr std::array<LADSPA_PortRangeHint, port_size>
 		port_range_hints
 		= get_elem<port_info_t::type::range_hint, port_size>(port_info);
@@ -936,11 +2220,11 @@ class builder
 		descriptor.implementation_data,
 		_instantiate<Plugin>,
 		_connect_port,
-		nullptr, //_activate,
+		helpers::has_activate<Plugin>::value ? _activate : nullptr,
 		_run,
 		nullptr, // run_adding
 		nullptr, // set_run_adding_gain
-		nullptr, // deactivate
+		helpers::has_deactivate<Plugin>::value ? _deactivate : nullptr,
 		_cleanup
 	};
 public:
@@ -1021,6 +2305,8 @@ struct correctness_checker
 
 }
 
+#endif // LADSPAPP_H
+
 // sources:
 // [1] http://stackoverflow.com/questions/16137468/
 //     sfinae-detect-constructor-with-one-argument
@@ -0,0 +1,466 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+
+#ifndef LADSPAPP_AUDIO_FILE_H
+#define LADSPAPP_AUDIO_FILE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../ladspa++.h"
+
+namespace ladspa
+{
+
+//! A file mapped read-only into memory
+class mapped_file
+{
+	const char* _data = nullptr;
+	std::size_t _size = 0;
+public:
+	mapped_file() {}
+	mapped_file(const mapped_file&) = delete;
+	mapped_file& operator=(const mapped_file&) = delete;
+	~mapped_file() { close(); }
+
+	//! @return false iff the file could not be mapped
+	bool open(const char* path)
+	{
+		close();
+		const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+		if(fd < 0)
+			return false;
+		struct stat st;
+		void* base = MAP_FAILED;
+		if(fstat(fd, &st) == 0 && st.st_size > 0)
+			base = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		::close(fd); // the mapping keeps the file
+		if(base == MAP_FAILED)
+			return false;
+		_data = static_cast<const char*>(base);
+		_size = st.st_size;
+		return true;
+	}
+
+	void close()
+	{
+		if(_data)
+			munmap(const_cast<char*>(_data), _size);
+		_data = nullptr;
+		_size = 0;
+	}
+
+	bool is_open() const { return _data != nullptr; }
+	const char* data() const { return _data; }
+	std::size_t size() const { return _size; }
+
+	//! Tells the kernel that the file will be read front to back
+	void advise_sequential() const {
+		if(_data)
+			madvise(const_cast<char*>(_data), _size, MADV_SEQUENTIAL);
+	}
+
+	//! Drops the mapped pages before byte @a end from memory, so streaming
+	//! through large files does not grow the resident memory
+	void drop_before(std::size_t end) const {
+		const std::size_t len = end & ~(std::size_t)(page_size() - 1);
+		if(_data && len)
+			madvise(const_cast<char*>(_data), std::min(len, _size),
+				MADV_DONTNEED);
+	}
+
+	static std::size_t page_size() { return sysconf(_SC_PAGESIZE); }
+};
+
+/**
+ * @brief Memory mapped, read-only audio file.
+ *
+ * Supported are WAV files with 16, 24 or 32 bit integer or 32 bit float
+ * samples, and headerless files of interleaved 32 bit floats (native byte
+ * order). The file is never copied as a whole; samples are converted on
+ * read() or read_frames().
+ *
+ * @note WAV files are only read correctly on little endian machines.
+ */
+class audio_file
+{
+public:
+	enum sample_format
+	{
+		pcm_16,
+		pcm_24,
+		pcm_32,
+		float_32
+	};
+
+private:
+	mapped_file _file;
+	const char* _samples = nullptr;
+	std::size_t _frames = 0;
+	unsigned _channels = 0;
+	unsigned _rate = 0;
+	sample_format _format = float_32;
+
+	template<class T>
+	static T get(const char* p) {
+		T res;
+		std::memcpy(&res, p, sizeof(T));
+		return res;
+	}
+
+	//! a packed 24 bit sample
+	struct pcm24 { unsigned char b[3]; };
+
+	static data convert(const char* p, std::int16_t*) {
+		return get<std::int16_t>(p) * (1.0f / 32768);
+	}
+	static data convert(const char* p, pcm24*) {
+		return (std::int32_t)((std::uint32_t)(unsigned char)p[0] << 8
+			| (std::uint32_t)(unsigned char)p[1] << 16
+			| (std::uint32_t)(unsigned char)p[2] << 24)
+			* (1.0f / 2147483648.0f);
+	}
+	static data convert(const char* p, std::int32_t*) {
+		return get<std::int32_t>(p) * (1.0f / 2147483648.0f);
+	}
+	static data convert(const char* p, float*) { return get<float>(p); }
+
+	//! one pass over the interleaved frames, with the channel count known
+	//! for the common cases, so the loops can be vectorized
+	template<class T, unsigned Ch>
+	static void deinterleave(const char* p, std::size_t n, data* const* out)
+	{
+		for(std::size_t i = 0; i < n; ++i)
+		for(unsigned c = 0; c < Ch; ++c)
+			out[c][i] = convert(p + (i * Ch + c) * sizeof(T), (T*)nullptr);
+	}
+
+	template<class T>
+	void deinterleave(const char* p, std::size_t n, data* const* out) const
+	{
+		switch(_channels)
+		{
+			case 1: deinterleave<T, 1>(p, n, out); break;
+			case 2: deinterleave<T, 2>(p, n, out); break;
+			default:
+				for(std::size_t i = 0; i < n; ++i)
+				for(unsigned c = 0; c < _channels; ++c)
+					out[c][i] = convert(p + (i * _channels + c)
+						* sizeof(T), (T*)nullptr);
+		}
+	}
+
+	std::size_t sample_bytes() const {
+		return (_format == pcm_16) ? 2 : (_format == pcm_24) ? 3 : 4;
+	}
+
+	bool parse_wav()
+	{
+		const char* p = _file.data();
+		const char* const end = p + _file.size();
+		if(std::memcmp(p + 8, "WAVE", 4))
+			return false;
+		bool have_fmt = false;
+		for(p += 12; p + 8 <= end; )
+		{
+			const std::uint32_t len = get<std::uint32_t>(p + 4);
+			const char* body = p + 8;
+			if(!std::memcmp(p, "fmt ", 4) && len >= 16)
+			{
+				std::uint16_t tag = get<std::uint16_t>(body);
+				if(tag == 0xfffe && len >= 40) // extensible
+					tag = get<std::uint16_t>(body + 24);
+				const std::uint16_t bits = get<std::uint16_t>(body + 14);
+				_channels = get<std::uint16_t>(body + 2);
+				_rate = get<std::uint32_t>(body + 4);
+				if(tag == 3 && bits == 32)
+					_format = float_32;
+				else if(tag == 1 && bits == 16)
+					_format = pcm_16;
+				else if(tag == 1 && bits == 24)
+					_format = pcm_24;
+				else if(tag == 1 && bits == 32)
+					_format = pcm_32;
+				else
+					return false;
+				have_fmt = _channels > 0;
+			}
+			else if(!std::memcmp(p, "data", 4) && have_fmt)
+			{
+				const std::size_t avail = std::min<std::size_t>(len,
+					end - body);
+				_samples = body;
+				_frames = avail / (sample_bytes() * _channels);
+				return true;
+			}
+			p = body + len + (len & 1);
+		}
+		return false;
+	}
+
+public:
+	/**
+	 * @param raw_channels Number of interleaved channels if the file
+	 *   turns out to be headerless
+	 * @return false iff the file could not be opened or parsed
+	 */
+	bool open(const char* path, unsigned raw_channels = 1)
+	{
+		close();
+		if(!_file.open(path))
+			return false;
+		if(_file.size() >= 12 && !std::memcmp(_file.data(), "RIFF", 4))
+		{
+			if(!parse_wav())
+			{
+				close();
+				return false;
+			}
+		}
+		else
+		{
+			_samples = _file.data();
+			_channels = std::max(raw_channels, 1u);
+			_frames = _file.size() / (sizeof(float) * _channels);
+			_format = float_32;
+		}
+		return true;
+	}
+
+	void close()
+	{
+		_file.close();
+		_samples = nullptr;
+		_frames = _channels = _rate = 0;
+	}
+
+	std::size_t frames() const { return _frames; }
+	unsigned channels() const { return _channels; }
+	//! sample rate, or 0 for headerless files
+	unsigned rate() const { return _rate; }
+	sample_format format() const { return _format; }
+	const mapped_file& file() const { return _file; }
+	//! byte offset of frame @a frame in the file
+	std::size_t offset(std::size_t frame) const {
+		return (_samples - _file.data())
+			+ frame * sample_bytes() * _channels;
+	}
+
+	/**
+	 * Converts @a n frames of @a channel, starting at frame @a first,
+	 * to floats in [-1, 1).
+	 */
+	void read(unsigned channel, std::size_t first, std::size_t n,
+		data* out) const
+	{
+		assert(channel < _channels && first + n <= _frames);
+		const std::size_t bytes = sample_bytes();
+		const std::size_t stride = bytes * _channels;
+		const char* p = _samples + first * stride + channel * bytes;
+		for(std::size_t i = 0; i < n; ++i, p += stride)
+		switch(_format)
+		{
+			case pcm_16: out[i] = convert(p, (std::int16_t*)nullptr); break;
+			case pcm_24: out[i] = convert(p, (pcm24*)nullptr); break;
+			case pcm_32: out[i] = convert(p, (std::int32_t*)nullptr); break;
+			case float_32: out[i] = convert(p, (float*)nullptr); break;
+		}
+	}
+
+	/**
+	 * Converts @a n frames, starting at frame @a first, to floats in
+	 * [-1, 1), and writes channel c to @a out[c].
+	 *
+	 * Unlike calling read() for each channel, this reads the file once,
+	 * front to back.
+	 */
+	void read_frames(std::size_t first, std::size_t n, data* const* out)
+		const
+	{
+		assert(first + n <= _frames);
+		const char* p = _samples + first * sample_bytes() * _channels;
+		switch(_format)
+		{
+			case pcm_16: deinterleave<std::int16_t>(p, n, out); break;
+			case pcm_24: deinterleave<pcm24>(p, n, out); break;
+			case pcm_32: deinterleave<std::int32_t>(p, n, out); break;
+			case float_32: deinterleave<float>(p, n, out); break;
+		}
+	}
+};
+
+/**
+ * @brief Writes WAV files, or headerless files of 32 bit floats, in a
+ *   streaming way.
+ *
+ * The channels are interleaved and converted into an internal buffer,
+ * which is written with one call per write().
+ */
+class audio_file_writer
+{
+	std::FILE* _file = nullptr;
+	unsigned _channels = 0;
+	unsigned _rate = 0;
+	audio_file::sample_format _format = audio_file::float_32;
+	bool _raw = false;
+	std::size_t _frames = 0;
+	std::vector<char> _buffer;
+
+	std::size_t sample_bytes() const {
+		return (_format == audio_file::pcm_16) ? 2
+			: (_format == audio_file::pcm_24) ? 3 : 4;
+	}
+
+	template<class T>
+	void put(char*& p, T value) {
+		std::memcpy(p, &value, sizeof(T));
+		p += sizeof(T);
+	}
+
+	static std::int32_t quantize(data x, double scale) {
+		const double v = std::max(-1.0, std::min((double)x, 1.0)) * scale;
+		return (std::int32_t)std::max(-scale, std::min(std::floor(v + 0.5),
+			scale - 1));
+	}
+
+	bool write_header(unsigned rate)
+	{
+		const std::size_t bytes = _frames * sample_bytes() * _channels;
+		// the sizes would wrap, better no header than a wrong one
+		if(!fits(_frames, _channels, _format))
+			return false;
+		const std::uint16_t tag = (_format == audio_file::float_32) ? 3 : 1;
+		const std::uint16_t block = sample_bytes() * _channels;
+		char header[44], *p = header;
+		std::memcpy(p, "RIFF", 4); p += 4;
+		put<std::uint32_t>(p, 36 + bytes);
+		std::memcpy(p, "WAVEfmt ", 8); p += 8;
+		put<std::uint32_t>(p, 16);
+		put<std::uint16_t>(p, tag);
+		put<std::uint16_t>(p, _channels);
+		put<std::uint32_t>(p, rate);
+		put<std::uint32_t>(p, rate * block);
+		put<std::uint16_t>(p, block);
+		put<std::uint16_t>(p, sample_bytes() * 8);
+		std::memcpy(p, "data", 4); p += 4;
+		put<std::uint32_t>(p, bytes);
+		return std::fwrite(header, sizeof(header), 1, _file) == 1;
+	}
+
+public:
+	//! Whether WAV files with @a frames frames of @a channels channels
+	//! in @a format have sizes that fit into their header. Headerless
+	//! files have no such limit.
+	static bool fits(std::size_t frames, unsigned channels,
+		audio_file::sample_format format)
+	{
+		const std::uint64_t bytes = (std::uint64_t)frames * channels
+			* ((format == audio_file::pcm_16) ? 2
+			: (format == audio_file::pcm_24) ? 3 : 4);
+		return bytes <= UINT32_MAX - 36;
+	}
+
+	audio_file_writer() {}
+	audio_file_writer(const audio_file_writer&) = delete;
+	audio_file_writer& operator=(const audio_file_writer&) = delete;
+	~audio_file_writer() { close(); }
+
+	/**
+	 * @param raw Whether to write headerless 32 bit floats, in which case
+	 *   @a format and @a rate are ignored
+	 * @return false iff the file could not be created
+	 */
+	bool open(const char* path, unsigned channels, unsigned rate,
+		audio_file::sample_format format, bool raw = false)
+	{
+		close();
+		_file = std::fopen(path, "wb");
+		_channels = channels;
+		_rate = rate;
+		_format = raw ? audio_file::float_32 : format;
+		_raw = raw;
+		_frames = 0;
+		return _file && (raw || write_header(rate));
+	}
+
+	//! Writes @a n frames, where channel c is read from @a in[c]
+	//! @return false iff writing failed, or a WAV file would get too
+	//!   large, see fits()
+	bool write(const data* const* in, std::size_t n)
+	{
+		if(!_raw && !fits(_frames + n, _channels, _format))
+			return false;
+		_buffer.resize(n * sample_bytes() * _channels);
+		char* p = _buffer.data();
+		for(std::size_t i = 0; i < n; ++i)
+		for(unsigned c = 0; c < _channels; ++c)
+		switch(_format)
+		{
+			case audio_file::pcm_16:
+				put<std::int16_t>(p, quantize(in[c][i], 32768.0));
+				break;
+			case audio_file::pcm_24:
+			{
+				const std::int32_t v = quantize(in[c][i], 8388608.0);
+				*p++ = v & 0xff;
+				*p++ = (v >> 8) & 0xff;
+				*p++ = (v >> 16) & 0xff;
+				break;
+			}
+			case audio_file::pcm_32:
+				put<std::int32_t>(p, quantize(in[c][i], 2147483648.0));
+				break;
+			case audio_file::float_32:
+				put<float>(p, in[c][i]);
+				break;
+		}
+		_frames += n;
+		return std::fwrite(_buffer.data(), 1, _buffer.size(), _file)
+			== _buffer.size();
+	}
+
+	//! Completes the header and closes the file
+	//! @return false iff anything could not be written
+	bool close()
+	{
+		if(!_file)
+			return true;
+		bool ok = true;
+		if(!_raw)
+			ok = std::fseek(_file, 0, SEEK_SET) == 0 && write_header(_rate);
+		ok = (std::fclose(_file) == 0) && ok;
+		_file = nullptr;
+		return ok;
+	}
+};
+
+}
+
+#endif // LADSPAPP_AUDIO_FILE_H
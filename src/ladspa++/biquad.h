@@ -0,0 +1,559 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#ifndef LADSPAPP_BIQUAD_H
+#define LADSPAPP_BIQUAD_H
+
+#include <algorithm>
+#include <cmath>
+
+#include "../ladspa++.h"
+
+namespace ladspa
+{
+
+/**
+ * @brief Coefficients of one biquad section, normalized to a0 = 1.
+ *
+ * The design functions follow the "Audio EQ Cookbook" by R. Bristow-Johnson.
+ */
+struct biquad_coeffs
+{
+	data b0, b1, b2, a1, a2;
+
+	bool operator==(const biquad_coeffs& o) const {
+		return b0 == o.b0 && b1 == o.b1 && b2 == o.b2
+			&& a1 == o.a1 && a2 == o.a2;
+	}
+	bool operator!=(const biquad_coeffs& o) const { return !(*this == o); }
+
+	//! passes the signal unchanged
+	static biquad_coeffs identity() { return { 1, 0, 0, 0, 0 }; }
+
+	static biquad_coeffs lowpass(double freq, double q, double rate) {
+		const double w = omega(freq, rate), c = std::cos(w);
+		const double alpha = std::sin(w) / (2 * q);
+		return normalize((1 - c) / 2, 1 - c, (1 - c) / 2,
+			1 + alpha, -2 * c, 1 - alpha);
+	}
+
+	static biquad_coeffs highpass(double freq, double q, double rate) {
+		const double w = omega(freq, rate), c = std::cos(w);
+		const double alpha = std::sin(w) / (2 * q);
+		return normalize((1 + c) / 2, -(1 + c), (1 + c) / 2,
+			1 + alpha, -2 * c, 1 - alpha);
+	}
+
+	//! band pass with a constant peak gain of 0 dB
+	static biquad_coeffs bandpass(double freq, double q, double rate) {
+		const double w = omega(freq, rate), c = std::cos(w);
+		const double alpha = std::sin(w) / (2 * q);
+		return normalize(alpha, 0, -alpha, 1 + alpha, -2 * c, 1 - alpha);
+	}
+
+	static biquad_coeffs notch(double freq, double q, double rate) {
+		const double w = omega(freq, rate), c = std::cos(w);
+		const double alpha = std::sin(w) / (2 * q);
+		return normalize(1, -2 * c, 1, 1 + alpha, -2 * c, 1 - alpha);
+	}
+
+	static biquad_coeffs peaking(double freq, double q, double gain_db,
+		double rate) {
+		const double w = omega(freq, rate), c = std::cos(w);
+		const double alpha = std::sin(w) / (2 * q);
+		const double a = std::pow(10.0, gain_db / 40);
+		return normalize(1 + alpha * a, -2 * c, 1 - alpha * a,
+			1 + alpha / a, -2 * c, 1 - alpha / a);
+	}
+
+	static biquad_coeffs low_shelf(double freq, double q, double gain_db,
+		double rate) {
+		const double w = omega(freq, rate), c = std::cos(w);
+		const double a = std::pow(10.0, gain_db / 40);
+		const double beta = 2 * std::sqrt(a) * std::sin(w) / (2 * q);
+		return normalize(a * ((a + 1) - (a - 1) * c + beta),
+			2 * a * ((a - 1) - (a + 1) * c),
+			a * ((a + 1) - (a - 1) * c - beta),
+			(a + 1) + (a - 1) * c + beta,
+			-2 * ((a - 1) + (a + 1) * c),
+			(a + 1) + (a - 1) * c - beta);
+	}
+
+	static biquad_coeffs high_shelf(double freq, double q, double gain_db,
+		double rate) {
+		const double w = omega(freq, rate), c = std::cos(w);
+		const double a = std::pow(10.0, gain_db / 40);
+		const double beta = 2 * std::sqrt(a) * std::sin(w) / (2 * q);
+		return normalize(a * ((a + 1) + (a - 1) * c + beta),
+			-2 * a * ((a - 1) + (a + 1) * c),
+			a * ((a + 1) + (a - 1) * c - beta),
+			(a + 1) - (a - 1) * c + beta,
+			2 * ((a - 1) - (a + 1) * c),
+			(a + 1) - (a - 1) * c - beta);
+	}
+
+	//! linear interpolation, @a t in [0, 1]
+	static biquad_coeffs lerp(const biquad_coeffs& from,
+		const biquad_coeffs& to, data t) {
+		return { from.b0 + (to.b0 - from.b0) * t,
+			from.b1 + (to.b1 - from.b1) * t,
+			from.b2 + (to.b2 - from.b2) * t,
+			from.a1 + (to.a1 - from.a1) * t,
+			from.a2 + (to.a2 - from.a2) * t };
+	}
+
+private:
+	static double omega(double freq, double rate) {
+		return 2 * 3.14159265358979323846 * freq / rate;
+	}
+	static biquad_coeffs normalize(double b0, double b1, double b2,
+		double a0, double a1, double a2) {
+		return { (data)(b0 / a0), (data)(b1 / a0), (data)(b2 / a0),
+			(data)(a1 / a0), (data)(a2 / a0) };
+	}
+};
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+namespace helpers
+{
+
+/**
+ * Moves coefficients towards a target within a given number of samples.
+ *
+ * Nothing is recomputed unless the target changes.
+ */
+class coeff_ramp
+{
+	biquad_coeffs _from = biquad_coeffs::identity();
+	biquad_coeffs _target = biquad_coeffs::identity();
+	std::size_t _length = 0; //!< ramp length in samples
+	std::size_t _pos = 0; //!< position in the ramp, == _length if idle
+public:
+	void set_length(std::size_t length) { _length = _pos = length; }
+
+	//! @return true iff this is a change
+	bool set(const biquad_coeffs& current, const biquad_coeffs& target) {
+		if(target == _target)
+			return false;
+		_from = current;
+		_target = target;
+		_pos = 0;
+		return true;
+	}
+
+	bool active() const { return _pos < _length; }
+	const biquad_coeffs& target() const { return _target; }
+
+	//! advances by @a n samples and returns the new coefficients
+	biquad_coeffs advance(std::size_t n) {
+		_pos = std::min(_length, _pos + n);
+		return (_pos == _length) ? _target
+			: biquad_coeffs::lerp(_from, _target, (data)_pos / _length);
+	}
+};
+
+}
+#endif /* DOXYGEN_SHOULD_SKIP_THIS */
+
+/**
+ * @brief A single biquad, processed sample by sample.
+ *
+ * This is the classic transposed direct form II loop. It is the reference
+ * for the faster classes below, and fine for short or modulated blocks.
+ */
+class biquad
+{
+	biquad_coeffs c = biquad_coeffs::identity();
+	data s1 = 0, s2 = 0;
+public:
+	void set(const biquad_coeffs& _c) { c = _c; }
+	const biquad_coeffs& coeffs() const { return c; }
+	void reset() { s1 = s2 = 0; }
+
+	data tick(data x) {
+		const data y = c.b0 * x + s1;
+		s1 = c.b1 * x - c.a1 * y + s2;
+		s2 = c.b2 * x - c.a2 * y;
+		return y;
+	}
+
+	//! @a in and @a out may be equal
+	void process(const data* in, data* out, std::size_t n) {
+		for(std::size_t i = 0; i < n; ++i)
+			out[i] = tick(in[i]);
+	}
+
+	void process(const const_buffer& in, buffer& out) {
+		process(in.data(), out.data(), out.size());
+	}
+};
+
+/**
+ * @brief A cascade of @a Sections biquads on one channel.
+ *
+ * Short cascades use the state space block formulation: four outputs are
+ * computed at once from four inputs and the state, with precomputed
+ * matrices. This removes the sample-to-sample dependency, so the inner
+ * loops work on four lanes and can be vectorized. Longer cascades run all
+ * sections for each sample, which overlaps their dependency chains.
+ *
+ * Coefficient changes are ramped over a settable number of samples. The
+ * matrices are only recomputed while a ramp is active.
+ */
+template<std::size_t Sections>
+class biquad_cascade
+{
+	static constexpr std::size_t lanes = 4;
+	//! size of the blocks while ramping
+	static constexpr std::size_t ramp_block = 16;
+
+	//! matrices to compute @a lanes samples of one section at once
+	struct section
+	{
+		data h[lanes][lanes]; //!< h[j][k]: input j to output k
+		data cs[2][lanes]; //!< cs[i][k]: state i to output k
+		data s[2]; //!< state
+		biquad_coeffs c;
+		helpers::coeff_ramp ramp;
+
+		void compute(const biquad_coeffs& _c)
+		{
+			c = _c;
+			// s' = A s + B x, y = C s + D x, with C = (1 0)
+			const double a[2][2] = { { -c.a1, 1 }, { -c.a2, 0 } };
+			const double b[2] = { c.b1 - c.a1 * c.b0,
+				c.b2 - c.a2 * c.b0 };
+			double ca[lanes][2]; // C A^k
+			ca[0][0] = 1; ca[0][1] = 0;
+			for(std::size_t k = 1; k < lanes; ++k)
+			{
+				ca[k][0] = ca[k-1][0] * a[0][0] + ca[k-1][1] * a[1][0];
+				ca[k][1] = ca[k-1][0] * a[0][1] + ca[k-1][1] * a[1][1];
+			}
+			for(std::size_t j = 0; j < lanes; ++j)
+			for(std::size_t k = 0; k < lanes; ++k)
+			{
+				h[j][k] = (k < j) ? 0
+					: (k == j) ? c.b0
+					: (data)(ca[k-1-j][0] * b[0] + ca[k-1-j][1] * b[1]);
+			}
+			for(std::size_t k = 0; k < lanes; ++k)
+			{
+				cs[0][k] = ca[k][0];
+				cs[1][k] = ca[k][1];
+			}
+		}
+
+		void process_block(const data* in, data* out)
+		{
+			data x[lanes], y[lanes];
+			for(std::size_t k = 0; k < lanes; ++k)
+				x[k] = in[k];
+			for(std::size_t k = 0; k < lanes; ++k)
+				y[k] = cs[0][k] * s[0] + cs[1][k] * s[1];
+			for(std::size_t j = 0; j < lanes; ++j)
+			for(std::size_t k = 0; k < lanes; ++k)
+				y[k] += h[j][k] * x[j];
+			// the new state only depends on the last two samples
+			const std::size_t l = lanes - 1;
+			s[0] = c.b1 * x[l] - c.a1 * y[l]
+				+ c.b2 * x[l-1] - c.a2 * y[l-1];
+			s[1] = c.b2 * x[l] - c.a2 * y[l];
+			for(std::size_t k = 0; k < lanes; ++k)
+				out[k] = y[k];
+		}
+
+		//! transposed direct form II, for the remainder
+		void process_single(const data* in, data* out, std::size_t n)
+		{
+			for(std::size_t i = 0; i < n; ++i)
+				out[i] = tick(in[i], s);
+		}
+
+		//! one sample with the state @a st, which may be a local copy
+		data tick(data x, data (&st)[2]) const
+		{
+			const data y = c.b0 * x + st[0];
+			st[0] = c.b1 * x - c.a1 * y + st[1];
+			st[1] = c.b2 * x - c.a2 * y;
+			return y;
+		}
+	};
+
+	section sections[Sections];
+
+	//! The block formulation only pays off while the matrices of all
+	//! sections fit into the registers. Longer cascades are not latency
+	//! bound anyways, since the sections' dependency chains overlap.
+	static constexpr bool use_blocks = Sections <= 2;
+
+	void process_blocks(const data* in, data* out, std::size_t n)
+	{
+		std::size_t i = 0;
+		for(; i + lanes <= n; i += lanes)
+		{
+			data x[lanes];
+			for(std::size_t k = 0; k < lanes; ++k)
+				x[k] = in[i + k];
+			for(section& s : sections)
+				s.process_block(x, x);
+			for(std::size_t k = 0; k < lanes; ++k)
+				out[i + k] = x[k];
+		}
+		for(section& s : sections)
+		{
+			s.process_single(in + i, out + i, n - i);
+			in = out;
+		}
+	}
+
+	//! all sections for each sample
+	void process_samples(const data* in, data* out, std::size_t n)
+	{
+		// local states, since writing to out might alias them
+		data st[Sections][2];
+		for(std::size_t j = 0; j < Sections; ++j)
+			std::copy(sections[j].s, sections[j].s + 2, st[j]);
+		for(std::size_t i = 0; i < n; ++i)
+		{
+			data x = in[i];
+			for(std::size_t j = 0; j < Sections; ++j)
+				x = sections[j].tick(x, st[j]);
+			out[i] = x;
+		}
+		for(std::size_t j = 0; j < Sections; ++j)
+			std::copy(st[j], st[j] + 2, sections[j].s);
+	}
+
+public:
+	biquad_cascade()
+	{
+		for(section& s : sections)
+		{
+			s.compute(biquad_coeffs::identity());
+			s.s[0] = s.s[1] = 0;
+		}
+	}
+
+	static constexpr std::size_t size() { return Sections; }
+
+	//! Number of samples over which coefficient changes are ramped
+	void set_smoothing(std::size_t samples)
+	{
+		for(section& s : sections)
+			s.ramp.set_length(samples);
+	}
+
+	//! Sets the target coefficients of section @a i.
+	//! Does nothing if they did not change.
+	void set(std::size_t i, const biquad_coeffs& c)
+	{
+		section& s = sections[i];
+		if(s.ramp.set(s.c, c) && !s.ramp.active())
+			s.compute(c); // no smoothing
+	}
+
+	const biquad_coeffs& coeffs(std::size_t i) const {
+		return sections[i].c;
+	}
+
+	//! Sets all states to zero
+	void reset()
+	{
+		for(section& s : sections)
+			s.s[0] = s.s[1] = 0;
+	}
+
+	//! @a in and @a out may be equal
+	void process(const data* in, data* out, std::size_t n)
+	{
+		bool ramping = false;
+		for(const section& s : sections)
+			ramping = ramping || s.ramp.active();
+		const std::size_t block = ramping ? ramp_block : n;
+
+		for(std::size_t done = 0; done < n; done += block)
+		{
+			const std::size_t cur = std::min(block, n - done);
+			for(section& s : sections)
+				if(s.ramp.active())
+					s.compute(s.ramp.advance(cur));
+
+			if(use_blocks)
+				process_blocks(in + done, out + done, cur);
+			else
+				process_samples(in + done, out + done, cur);
+		}
+	}
+
+	void process(const const_buffer& in, buffer& out) {
+		process(in.data(), out.data(), out.size());
+	}
+};
+
+/**
+ * @brief @a Bands biquads which run in parallel.
+ *
+ * The coefficients and states are stored band by band in arrays, so each
+ * sample is computed for all bands at once, and the loops over the bands
+ * can be vectorized. Use it for filter banks (all bands filter one input,
+ * e.g. crossovers) or for one filter per channel (e.g. of a port group).
+ *
+ * Coefficient changes are ramped like in biquad_cascade.
+ */
+template<std::size_t Bands>
+class biquad_bank
+{
+	//! number of samples transposed at once
+	static constexpr std::size_t tile = 16;
+
+	data b0[Bands], b1[Bands], b2[Bands], a1[Bands], a2[Bands];
+	data s1[Bands], s2[Bands];
+	helpers::coeff_ramp ramps[Bands];
+
+	void assign(std::size_t i, const biquad_coeffs& c) {
+		b0[i] = c.b0; b1[i] = c.b1; b2[i] = c.b2;
+		a1[i] = c.a1; a2[i] = c.a2;
+	}
+
+	biquad_coeffs current(std::size_t i) const {
+		return { b0[i], b1[i], b2[i], a1[i], a2[i] };
+	}
+
+	void advance_ramps(std::size_t n) {
+		for(std::size_t i = 0; i < Bands; ++i)
+			if(ramps[i].active())
+				assign(i, ramps[i].advance(n));
+	}
+
+	bool ramping() const {
+		for(const helpers::coeff_ramp& r : ramps)
+			if(r.active())
+				return true;
+		return false;
+	}
+
+	//! filters @a n <= tile samples of all bands, x[i][band]
+	void process_tile(data (&x)[tile][Bands], std::size_t n)
+	{
+		for(std::size_t i = 0; i < n; ++i)
+		for(std::size_t b = 0; b < Bands; ++b)
+		{
+			const data in = x[i][b];
+			const data y = b0[b] * in + s1[b];
+			s1[b] = b1[b] * in - a1[b] * y + s2[b];
+			s2[b] = b2[b] * in - a2[b] * y;
+			x[i][b] = y;
+		}
+	}
+
+public:
+	biquad_bank()
+	{
+		for(std::size_t i = 0; i < Bands; ++i)
+			assign(i, biquad_coeffs::identity());
+		reset();
+	}
+
+	static constexpr std::size_t size() { return Bands; }
+
+	//! Number of samples over which coefficient changes are ramped
+	void set_smoothing(std::size_t samples)
+	{
+		for(helpers::coeff_ramp& r : ramps)
+			r.set_length(samples);
+	}
+
+	//! Sets the target coefficients of band @a i.
+	//! Does nothing if they did not change.
+	void set(std::size_t i, const biquad_coeffs& c)
+	{
+		if(ramps[i].set(current(i), c) && !ramps[i].active())
+			assign(i, c); // no smoothing
+	}
+
+	biquad_coeffs coeffs(std::size_t i) const { return current(i); }
+
+	//! Sets all states to zero
+	void reset()
+	{
+		std::fill(s1, s1 + Bands, 0.0f);
+		std::fill(s2, s2 + Bands, 0.0f);
+	}
+
+	//! Band i filters channel @a in[i] into @a out[i].
+	//! @a in[i] and @a out[i] may be equal.
+	void process(const data* const* in, data* const* out, std::size_t n)
+	{
+		data x[tile][Bands];
+		const bool ramp = ramping();
+		for(std::size_t done = 0; done < n; done += tile)
+		{
+			const std::size_t cur = std::min(tile, n - done);
+			if(ramp)
+				advance_ramps(cur);
+			for(std::size_t b = 0; b < Bands; ++b)
+			for(std::size_t i = 0; i < cur; ++i)
+				x[i][b] = in[b][done + i];
+			process_tile(x, cur);
+			for(std::size_t b = 0; b < Bands; ++b)
+			for(std::size_t i = 0; i < cur; ++i)
+				out[b][done + i] = x[i][b];
+		}
+	}
+
+	//! All bands filter @a in, band i writes to @a out[i].
+	void process(const data* in, data* const* out, std::size_t n)
+	{
+		data x[tile][Bands];
+		const bool ramp = ramping();
+		for(std::size_t done = 0; done < n; done += tile)
+		{
+			const std::size_t cur = std::min(tile, n - done);
+			if(ramp)
+				advance_ramps(cur);
+			for(std::size_t i = 0; i < cur; ++i)
+			for(std::size_t b = 0; b < Bands; ++b)
+				x[i][b] = in[done + i];
+			process_tile(x, cur);
+			for(std::size_t b = 0; b < Bands; ++b)
+			for(std::size_t i = 0; i < cur; ++i)
+				out[b][done + i] = x[i][b];
+		}
+	}
+
+	//! one band per channel of a port group
+	void process(const port_group_template<const_buffer, Bands>& in,
+		const port_group_template<buffer, Bands>& out)
+	{
+		process(in.data(), out.data(), out.sample_count());
+	}
+
+	//! one band per channel of the output port group
+	void process(const const_buffer& in,
+		const port_group_template<buffer, Bands>& out)
+	{
+		process(in.data(), out.data(), out.sample_count());
+	}
+};
+
+}
+
+#endif // LADSPAPP_BIQUAD_H
@@ -0,0 +1,64 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#ifndef LADSPAPP_CONTROL_DEFAULTS_H
+#define LADSPAPP_CONTROL_DEFAULTS_H
+
+#include <cmath>
+
+#include "../ladspa++.h"
+
+namespace ladspa
+{
+
+//! Returns the default value that the range hint of a control port
+//! suggests, or 0 if it has none
+inline data default_control_value(const LADSPA_PortRangeHint& hint,
+	sample_rate_t rate)
+{
+	const LADSPA_PortRangeHintDescriptor d = hint.HintDescriptor;
+	const double scale = (d & LADSPA_HINT_SAMPLE_RATE) ? rate : 1;
+	const double lo = hint.LowerBound * scale, hi = hint.UpperBound * scale;
+	const bool log = (d & LADSPA_HINT_LOGARITHMIC) && lo > 0 && hi > 0;
+	auto between = [&](double t) {
+		return log ? std::exp(std::log(lo) * (1 - t) + std::log(hi) * t)
+			: lo * (1 - t) + hi * t;
+	};
+	double res = 0;
+	switch(d & LADSPA_HINT_DEFAULT_MASK)
+	{
+		case LADSPA_HINT_DEFAULT_MINIMUM: res = lo; break;
+		case LADSPA_HINT_DEFAULT_LOW: res = between(0.25); break;
+		case LADSPA_HINT_DEFAULT_MIDDLE: res = between(0.5); break;
+		case LADSPA_HINT_DEFAULT_HIGH: res = between(0.75); break;
+		case LADSPA_HINT_DEFAULT_MAXIMUM: res = hi; break;
+		case LADSPA_HINT_DEFAULT_1: res = 1; break;
+		case LADSPA_HINT_DEFAULT_100: res = 100; break;
+		case LADSPA_HINT_DEFAULT_440: res = 440; break;
+		default: res = 0;
+	}
+	if((d & LADSPA_HINT_INTEGER))
+		res = std::floor(res + 0.5);
+	return (data)res;
+}
+
+}
+
+#endif // LADSPAPP_CONTROL_DEFAULTS_H
@@ -0,0 +1,285 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+
+#ifndef LADSPAPP_CONVOLVER_H
+#define LADSPAPP_CONVOLVER_H
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "audio_file.h"
+#include "fft.h"
+#include "shared_resource.h"
+
+namespace ladspa
+{
+
+/**
+ * @brief An impulse response, split into partitions of equal size and
+ *   transformed into the frequency domain.
+ *
+ * Objects are immutable after construction, so one object can be shared
+ * by any number of convolver instances (and threads).
+ */
+class ir_spectra
+{
+	std::size_t _block, _length, _partitions;
+	fft _fft; //!< of size 2 * block
+	std::vector<data> _head; //!< the first partition, time domain
+	std::vector<data> _re, _im; //!< all partitions, _fft.bins() each
+
+	void init(std::size_t length, std::size_t block)
+	{
+		_block = block;
+		_length = length;
+		_partitions = (length + block - 1) / block;
+		_fft.resize(2 * block);
+		_head.assign(block, 0);
+		_re.resize(_partitions * _fft.bins());
+		_im.resize(_partitions * _fft.bins());
+	}
+
+	//! @a taps contains @a n <= block() samples of partition @a p
+	void set_partition(std::size_t p, const data* taps, std::size_t n)
+	{
+		if(!p)
+			std::copy(taps, taps + n, _head.begin());
+		// zero padded to the fft size, and scaled for the inverse fft
+		std::vector<data> padded(_fft.size(), 0);
+		const data scale = (data)1 / _fft.size();
+		for(std::size_t i = 0; i < n; ++i)
+			padded[i] = taps[i] * scale;
+		_fft.forward(padded.data(), &_re[p * _fft.bins()],
+			&_im[p * _fft.bins()]);
+	}
+
+public:
+	/**
+	 * @param ir The impulse response
+	 * @param length Number of samples of @a ir
+	 * @param block Partition size, a power of 2, at least 2
+	 */
+	ir_spectra(const data* ir, std::size_t length, std::size_t block)
+	{
+		init(length, block);
+		for(std::size_t p = 0; p < _partitions; ++p)
+			set_partition(p, ir + p * block,
+				std::min(block, length - p * block));
+	}
+
+	//! Uses channel @a channel of @a file, one partition at a time
+	ir_spectra(const audio_file& file, unsigned channel, std::size_t block)
+	{
+		init(file.frames(), block);
+		std::vector<data> taps(block);
+		for(std::size_t p = 0; p < _partitions; ++p)
+		{
+			const std::size_t n = std::min(block, _length - p * block);
+			file.read(channel, p * block, n, taps.data());
+			set_partition(p, taps.data(), n);
+		}
+	}
+
+	/**
+	 * Loads an impulse response file (see audio_file), or returns the
+	 * already loaded one if another instance still uses it.
+	 *
+	 * Not realtime safe, call it from your plugin's constructor or
+	 * activate() function.
+	 * @return nullptr iff the file could not be read
+	 */
+	static std::shared_ptr<const ir_spectra> load(const char* path,
+		std::size_t block, unsigned channel = 0)
+	{
+		typedef std::tuple<std::string, std::size_t, unsigned> key;
+		return shared_resource<ir_spectra, key>::get(
+			key(path, block, channel),
+			[&]() -> ir_spectra* {
+			audio_file file;
+			if(!file.open(path) || channel >= file.channels()
+				|| !file.frames())
+				return nullptr;
+			return new ir_spectra(file, channel, block);
+		});
+	}
+
+	std::size_t block() const { return _block; }
+	//! length of the impulse response, in samples
+	std::size_t length() const { return _length; }
+	std::size_t partitions() const { return _partitions; }
+	const fft& transform() const { return _fft; }
+
+	//! the first min(block(), length()) samples of the impulse response
+	const data* head() const { return _head.data(); }
+	const data* re(std::size_t p) const { return &_re[p * _fft.bins()]; }
+	const data* im(std::size_t p) const { return &_im[p * _fft.bins()]; }
+};
+
+/**
+ * @brief Uniformly partitioned convolution (overlap-save with a frequency
+ *   domain delay line).
+ *
+ * With zero latency, the first partition is convolved directly in the time
+ * domain, and the others via FFT. Otherwise, all partitions use the FFT and
+ * the output is delayed by one partition, see latency().
+ *
+ * All memory is allocated in prepare(), which you should call in your
+ * plugin's activate() function. process() accepts any number of samples.
+ */
+class convolver
+{
+	std::shared_ptr<const ir_spectra> _ir;
+	std::size_t _block = 0;
+	std::size_t _first = 0; //!< first partition that uses the fft
+	std::size_t _slots = 0; //!< size of the delay line, in spectra
+	std::size_t _slot = 0; //!< slot of the newest input spectrum
+	std::size_t _pos = 0; //!< position in the current block
+
+	std::vector<data> _input; //!< the last and the current input block
+	std::vector<data> _output; //!< fft part of the current output block
+	std::vector<data> _fdl_re, _fdl_im; //!< spectra of past input blocks
+	std::vector<data> _acc_re, _acc_im, _time; //!< scratch
+
+	//! called whenever an input block is complete
+	void process_partitions()
+	{
+		const fft& f = _ir->transform();
+		const std::size_t bins = f.bins();
+		_slot = _slot ? _slot - 1 : _slots - 1;
+		data* const xr = &_fdl_re[_slot * bins];
+		data* const xi = &_fdl_im[_slot * bins];
+		f.forward(_input.data(), xr, xi);
+
+		std::fill(_acc_re.begin(), _acc_re.end(), 0);
+		std::fill(_acc_im.begin(), _acc_im.end(), 0);
+		for(std::size_t p = _first, s = _slot; p < _ir->partitions(); ++p)
+		{
+			const data *hr = _ir->re(p), *hi = _ir->im(p);
+			const data *xr = &_fdl_re[s * bins], *xi = &_fdl_im[s * bins];
+			data *ar = _acc_re.data(), *ai = _acc_im.data();
+			for(std::size_t k = 0; k < bins; ++k)
+			{
+				ar[k] += hr[k] * xr[k] - hi[k] * xi[k];
+				ai[k] += hr[k] * xi[k] + hi[k] * xr[k];
+			}
+			s = (s + 1 == _slots) ? 0 : s + 1;
+		}
+		f.inverse(_acc_re.data(), _acc_im.data(), _time.data());
+
+		// overlap-save: only the second half is valid
+		std::copy(_time.begin() + _block, _time.end(), _output.begin());
+		std::copy(_input.begin() + _block, _input.end(), _input.begin());
+	}
+
+public:
+	/**
+	 * Allocates all buffers and clears the state.
+	 * @param zero_latency Whether to convolve the first partition directly
+	 */
+	void prepare(std::shared_ptr<const ir_spectra> ir,
+		bool zero_latency = true)
+	{
+		_ir = std::move(ir);
+		_block = _ir->block();
+		_first = zero_latency ? 1 : 0;
+		_slots = std::max(_ir->partitions(), _first + 1) - _first;
+		const std::size_t bins = _ir->transform().bins();
+		_input.resize(2 * _block);
+		_output.resize(_block);
+		_fdl_re.resize(_slots * bins);
+		_fdl_im.resize(_slots * bins);
+		_acc_re.resize(bins);
+		_acc_im.resize(bins);
+		_time.resize(2 * _block);
+		reset();
+	}
+
+	//! Frees all memory, including the impulse response if unused
+	void release()
+	{
+		*this = convolver();
+	}
+
+	//! Clears all past input
+	void reset()
+	{
+		std::fill(_input.begin(), _input.end(), 0);
+		std::fill(_output.begin(), _output.end(), 0);
+		std::fill(_fdl_re.begin(), _fdl_re.end(), 0);
+		std::fill(_fdl_im.begin(), _fdl_im.end(), 0);
+		_slot = _pos = 0;
+	}
+
+	bool is_prepared() const { return _ir != nullptr; }
+	const std::shared_ptr<const ir_spectra>& ir() const { return _ir; }
+
+	//! Delay of the output, in samples
+	std::size_t latency() const { return _first ? 0 : _block; }
+
+	//! @a in and @a out may be equal
+	void process(const data* in, data* out, std::size_t n)
+	{
+		if(!_ir)
+		{
+			std::fill(out, out + n, 0);
+			return;
+		}
+		const std::size_t head = _first
+			? std::min(_block, _ir->length()) : 0;
+		const data* const h = _ir->head();
+		while(n)
+		{
+			const std::size_t cur = std::min(n, _block - _pos);
+			data* const x = &_input[_block + _pos];
+			std::copy(in, in + cur, x);
+			std::copy(&_output[_pos], &_output[_pos] + cur, out);
+			// the input of the last block precedes x, so no wrapping
+			for(std::size_t k = 0; k < head; ++k)
+			for(std::size_t i = 0; i < cur; ++i)
+				out[i] += h[k] * (x - k)[i];
+
+			_pos += cur;
+			if(_pos == _block)
+			{
+				_pos = 0;
+				if(_ir->partitions() > _first)
+					process_partitions();
+				else
+					std::copy(_input.begin() + _block, _input.end(),
+						_input.begin());
+			}
+			in += cur;
+			out += cur;
+			n -= cur;
+		}
+	}
+
+	void process(const const_buffer& in, buffer& out) {
+		process(in.data(), out.data(), out.size());
+	}
+};
+
+}
+
+#endif // LADSPAPP_CONVOLVER_H
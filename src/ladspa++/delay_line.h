@@ -0,0 +1,240 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#ifndef LADSPAPP_DELAY_LINE_H
+#define LADSPAPP_DELAY_LINE_H
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "../ladspa++.h"
+
+namespace ladspa
+{
+
+/**
+ * @brief A ring buffer of samples where each window of the history is
+ *   contiguous.
+ *
+ * Reads and writes never need a modulo or a branch per sample, so they can
+ * be done with memcpy or vectorized loops, even across the wrap point.
+ *
+ * On Linux, the memory is mapped twice, back to back (using memfd). If that
+ * fails, the buffer is allocated twice as large and each write is copied
+ * into the mirrored half, too.
+ *
+ * Allocation is not realtime safe, so call allocate() in your plugin's
+ * activate() function.
+ */
+class delay_line
+{
+	data* _buffer = nullptr;
+	std::size_t _size = 0; //!< power of 2, in samples
+	std::size_t _mask = 0;
+	std::size_t _pos = 0; //!< write position, not masked
+	std::size_t _max_delay = 0;
+	bool _mirrored = false; //!< true iff the memory is mapped twice
+
+#ifdef __linux__
+	bool map_twice(std::size_t bytes)
+	{
+		int fd = memfd_create("ladspa++ delay line", MFD_CLOEXEC);
+		if(fd < 0)
+			return false;
+		void* base = MAP_FAILED;
+		if(ftruncate(fd, bytes) == 0)
+		{
+			// reserve both halves, then map the file into each
+			base = mmap(nullptr, 2 * bytes, PROT_NONE,
+				MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		}
+		if(base != MAP_FAILED)
+		{
+			char* half = static_cast<char*>(base);
+			if(mmap(half, bytes, PROT_READ | PROT_WRITE,
+				MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED
+				|| mmap(half + bytes, bytes, PROT_READ | PROT_WRITE,
+				MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED)
+			{
+				munmap(base, 2 * bytes);
+				base = MAP_FAILED;
+			}
+		}
+		close(fd);
+		if(base == MAP_FAILED)
+			return false;
+		_buffer = static_cast<data*>(base);
+		return true;
+	}
+#endif
+
+	static std::size_t next_pow2(std::size_t n)
+	{
+		std::size_t res = 1;
+		while(res < n)
+			res <<= 1;
+		return res;
+	}
+
+	//! copies @a n <= size() samples to @a dest, wrapping at size()
+	void copy_wrapped(std::size_t dest, const data* src, std::size_t n)
+	{
+		const std::size_t first = std::min(n, _size - dest);
+		std::memcpy(_buffer + dest, src, first * sizeof(data));
+		std::memcpy(_buffer, src + first, (n - first) * sizeof(data));
+	}
+
+public:
+	delay_line() {}
+	delay_line(const delay_line&) = delete;
+	delay_line& operator=(const delay_line&) = delete;
+	~delay_line() { release(); }
+
+	/**
+	 * Allocates the buffer and clears it.
+	 * @param max_delay The maximum delay, in samples, that will be read
+	 * @param max_block The maximum number of samples written at once
+	 * @return false iff no memory could be allocated
+	 */
+	bool allocate(std::size_t max_delay, std::size_t max_block = 4096)
+	{
+		release();
+		const std::size_t page_samples
+#ifdef __linux__
+			= sysconf(_SC_PAGESIZE) / sizeof(data);
+#else
+			= 1;
+#endif
+		_size = next_pow2(std::max(max_delay + max_block, page_samples));
+		_mask = _size - 1;
+		_max_delay = max_delay;
+#ifdef __linux__
+		_mirrored = map_twice(_size * sizeof(data));
+#endif
+		if(!_mirrored)
+			_buffer = new (std::nothrow) data[2 * _size];
+		if(!_buffer)
+			_size = _mask = _max_delay = 0;
+		clear();
+		return _buffer != nullptr;
+	}
+
+	//! Frees the buffer. Call it in deactivate() if you want.
+	void release()
+	{
+		if(_buffer)
+		{
+#ifdef __linux__
+			if(_mirrored)
+				munmap(_buffer, 2 * _size * sizeof(data));
+			else
+#endif
+			delete[] _buffer;
+		}
+		_buffer = nullptr;
+		_mirrored = false;
+		_size = _mask = _max_delay = _pos = 0;
+	}
+
+	//! Sets the whole history to zero
+	void clear()
+	{
+		if(_buffer)
+			std::memset(_buffer, 0, (_mirrored ? 1 : 2) * _size
+				* sizeof(data));
+		_pos = 0;
+	}
+
+	//! Maximum number of samples that write() accepts at once
+	std::size_t max_block() const { return _size - _max_delay; }
+	std::size_t max_delay() const { return _max_delay; }
+	//! true iff the buffer is mapped twice, and not mirrored by copying
+	bool is_mapped_twice() const { return _mirrored; }
+
+	//! Appends @a n <= max_block() samples to the history
+	void write(const data* in, std::size_t n)
+	{
+		assert(n <= max_block());
+		const std::size_t dest = _pos & _mask;
+		if(_mirrored)
+			std::memcpy(_buffer + dest, in, n * sizeof(data));
+		else
+		{
+			copy_wrapped(dest, in, n);
+			// mirror the written samples into the second half
+			const std::size_t first = std::min(n, _size - dest);
+			std::memcpy(_buffer + _size + dest, in,
+				first * sizeof(data));
+			std::memcpy(_buffer + _size, in + first,
+				(n - first) * sizeof(data));
+		}
+		_pos += n;
+	}
+
+	/**
+	 * Returns a contiguous window of @a n samples, delayed by @a delay
+	 * samples relative to the last @a n written samples.
+	 *
+	 * Element k of the window is the sample written @a delay samples before
+	 * the k-th of the last @a n written samples.
+	 * @a delay must be at most max_delay(), @a n at most max_block().
+	 */
+	const data* window(std::size_t delay, std::size_t n) const
+	{
+		assert(delay <= _max_delay && n <= max_block());
+		return _buffer + ((_pos - n - delay) & _mask);
+	}
+
+	//! Returns the sample written @a delay samples before the last one
+	data at(std::size_t delay) const
+	{
+		return _buffer[(_pos - 1 - delay) & _mask];
+	}
+
+	//! Writes @a in, and copies the input delayed by @a delay to @a out.
+	//! @a in and @a out may be equal, and may have any size.
+	void process(const data* in, data* out, std::size_t n,
+		std::size_t delay)
+	{
+		const std::size_t block = max_block();
+		if(!block) // not allocated
+		{
+			std::memset(out, 0, n * sizeof(data));
+			return;
+		}
+		for(std::size_t done = 0; done < n; done += block)
+		{
+			const std::size_t cur = std::min(block, n - done);
+			write(in + done, cur);
+			std::memcpy(out + done, window(delay, cur),
+				cur * sizeof(data));
+		}
+	}
+};
+
+}
+
+#endif // LADSPAPP_DELAY_LINE_H
@@ -0,0 +1,282 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#ifndef LADSPAPP_EXPRESSION_H
+#define LADSPAPP_EXPRESSION_H
+
+#include <cmath>
+#include <type_traits>
+
+#include "../ladspa++.h"
+
+namespace ladspa
+{
+
+/*
+ * Expression templates for buffers
+ *
+ * Arithmetic on buffers, e.g.
+ * @code
+ * out = in_a * gain_a + in_b * gain_b;
+ * out += tanh(in) * mix;
+ * @endcode
+ * builds a tree of small objects. Nothing is computed until the tree is
+ * assigned to a buffer, which then evaluates it in one loop, without any
+ * temporary buffers. Operands can be buffers, control ports and numbers;
+ * control ports are read once, when the expression is built.
+ *
+ * The loop runs over the size of the assigned buffer.
+ */
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+namespace helpers
+{
+
+//! leaf: the samples of a buffer
+class expr_buffer
+{
+	const data* _data;
+public:
+	typedef void expression_tag;
+	explicit expr_buffer(const data* _in_data) : _data(_in_data) {}
+	data operator[](std::size_t i) const { return _data[i]; }
+};
+
+//! leaf: the same value for each sample
+class expr_scalar
+{
+	data _value;
+public:
+	typedef void expression_tag;
+	explicit expr_scalar(data _in_value) : _value(_in_value) {}
+	data operator[](std::size_t) const { return _value; }
+};
+
+template<class Op, class E>
+class expr_unary
+{
+	E _e;
+public:
+	typedef void expression_tag;
+	explicit expr_unary(const E& e) : _e(e) {}
+	data operator[](std::size_t i) const { return Op::apply(_e[i]); }
+};
+
+template<class Op, class L, class R>
+class expr_binary
+{
+	L _l;
+	R _r;
+public:
+	typedef void expression_tag;
+	expr_binary(const L& l, const R& r) : _l(l), _r(r) {}
+	data operator[](std::size_t i) const {
+		return Op::apply(_l[i], _r[i]);
+	}
+};
+
+struct op_add { static data apply(data a, data b) { return a + b; } };
+struct op_sub { static data apply(data a, data b) { return a - b; } };
+struct op_mul { static data apply(data a, data b) { return a * b; } };
+struct op_div { static data apply(data a, data b) { return a / b; } };
+struct op_neg { static data apply(data a) { return -a; } };
+struct op_abs { static data apply(data a) { return std::fabs(a); } };
+struct op_sqrt { static data apply(data a) { return std::sqrt(a); } };
+struct op_exp { static data apply(data a) { return std::exp(a); } };
+struct op_sin { static data apply(data a) { return std::sin(a); } };
+struct op_cos { static data apply(data a) { return std::cos(a); } };
+struct op_tanh { static data apply(data a) { return std::tanh(a); } };
+
+/**
+ * Converts an operand into an expression node.
+ *
+ * is_signal is true for operands that change from sample to sample.
+ * Other types are no operands, so the operators ignore them.
+ */
+template<class T, class Enable = void>
+struct operand {};
+
+template<class T>
+struct operand<T, typename T::expression_tag>
+{
+	typedef T type;
+	static constexpr bool is_signal = true;
+	static const T& make(const T& e) { return e; }
+};
+
+template<class T>
+struct operand<buffer_template<T>>
+{
+	typedef expr_buffer type;
+	static constexpr bool is_signal = true;
+	static type make(const buffer_template<T>& b) {
+		return type(b.data());
+	}
+};
+
+template<class T>
+struct operand<pointer_template<T>>
+{
+	typedef expr_scalar type;
+	static constexpr bool is_signal = false;
+	static type make(const pointer_template<T>& p) {
+		return type(static_cast<const T&>(p));
+	}
+};
+
+template<class T>
+struct operand<T, typename std::enable_if<
+	std::is_arithmetic<T>::value>::type>
+{
+	typedef expr_scalar type;
+	static constexpr bool is_signal = false;
+	static type make(T v) { return type(static_cast<data>(v)); }
+};
+
+//! true for all types which operand<> can convert
+template<class T, class Enable = void>
+struct is_operand : std::false_type {};
+
+template<class T>
+struct is_operand<T, typename std::enable_if<
+	!std::is_void<typename operand<T>::type>::value>::type>
+	: std::true_type {};
+
+//! true for the operands which change from sample to sample, i.e.
+//! expressions and buffers
+template<class T, class Enable = void>
+struct is_signal : std::false_type {};
+
+template<class T>
+struct is_signal<T, typename std::enable_if<
+	operand<T>::is_signal>::type> : std::true_type {};
+
+//! whether L and R may be combined by a binary operator: at least one
+//! side must be a signal, so that e.g. float * float stays untouched
+template<class L, class R>
+struct is_binary_operand : std::integral_constant<bool,
+	is_operand<L>::value && is_operand<R>::value
+	&& (is_signal<L>::value || is_signal<R>::value)> {};
+
+//! the node of a binary operator
+template<class Op, class L, class R>
+struct binary_expr
+{
+	typedef expr_binary<Op, typename operand<L>::type,
+		typename operand<R>::type> type;
+	static type make(const L& l, const R& r) {
+		return type(operand<L>::make(l), operand<R>::make(r));
+	}
+};
+
+//! the node of a unary function
+template<class Op, class E>
+struct unary_expr
+{
+	typedef expr_unary<Op, typename operand<E>::type> type;
+	static type make(const E& e) { return type(operand<E>::make(e)); }
+};
+
+}
+#endif /* DOXYGEN_SHOULD_SKIP_THIS */
+
+// the operators and functions below are only visible if an argument is
+// an expression or a buffer, so they never hide the ones for numbers
+
+template<class L, class R>
+typename std::enable_if<helpers::is_binary_operand<L, R>::value,
+	helpers::binary_expr<helpers::op_add, L, R>>::type::type
+operator+(const L& l, const R& r) {
+	return helpers::binary_expr<helpers::op_add, L, R>::make(l, r);
+}
+
+template<class L, class R>
+typename std::enable_if<helpers::is_binary_operand<L, R>::value,
+	helpers::binary_expr<helpers::op_sub, L, R>>::type::type
+operator-(const L& l, const R& r) {
+	return helpers::binary_expr<helpers::op_sub, L, R>::make(l, r);
+}
+
+template<class L, class R>
+typename std::enable_if<helpers::is_binary_operand<L, R>::value,
+	helpers::binary_expr<helpers::op_mul, L, R>>::type::type
+operator*(const L& l, const R& r) {
+	return helpers::binary_expr<helpers::op_mul, L, R>::make(l, r);
+}
+
+template<class L, class R>
+typename std::enable_if<helpers::is_binary_operand<L, R>::value,
+	helpers::binary_expr<helpers::op_div, L, R>>::type::type
+operator/(const L& l, const R& r) {
+	return helpers::binary_expr<helpers::op_div, L, R>::make(l, r);
+}
+
+template<class E>
+typename std::enable_if<helpers::is_signal<E>::value,
+	helpers::unary_expr<helpers::op_neg, E>>::type::type
+operator-(const E& e) {
+	return helpers::unary_expr<helpers::op_neg, E>::make(e);
+}
+
+template<class E>
+typename std::enable_if<helpers::is_signal<E>::value,
+	helpers::unary_expr<helpers::op_abs, E>>::type::type
+abs(const E& e) {
+	return helpers::unary_expr<helpers::op_abs, E>::make(e);
+}
+
+template<class E>
+typename std::enable_if<helpers::is_signal<E>::value,
+	helpers::unary_expr<helpers::op_sqrt, E>>::type::type
+sqrt(const E& e) {
+	return helpers::unary_expr<helpers::op_sqrt, E>::make(e);
+}
+
+template<class E>
+typename std::enable_if<helpers::is_signal<E>::value,
+	helpers::unary_expr<helpers::op_exp, E>>::type::type
+exp(const E& e) {
+	return helpers::unary_expr<helpers::op_exp, E>::make(e);
+}
+
+template<class E>
+typename std::enable_if<helpers::is_signal<E>::value,
+	helpers::unary_expr<helpers::op_sin, E>>::type::type
+sin(const E& e) {
+	return helpers::unary_expr<helpers::op_sin, E>::make(e);
+}
+
+template<class E>
+typename std::enable_if<helpers::is_signal<E>::value,
+	helpers::unary_expr<helpers::op_cos, E>>::type::type
+cos(const E& e) {
+	return helpers::unary_expr<helpers::op_cos, E>::make(e);
+}
+
+template<class E>
+typename std::enable_if<helpers::is_signal<E>::value,
+	helpers::unary_expr<helpers::op_tanh, E>>::type::type
+tanh(const E& e) {
+	return helpers::unary_expr<helpers::op_tanh, E>::make(e);
+}
+
+}
+
+#endif // LADSPAPP_EXPRESSION_H
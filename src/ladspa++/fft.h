@@ -0,0 +1,189 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+
+#ifndef LADSPAPP_FFT_H
+#define LADSPAPP_FFT_H
+
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "../ladspa++.h"
+
+namespace ladspa
+{
+
+/**
+ * @brief A small radix 2 FFT for real signals.
+ *
+ * Spectra are stored as separate real and imaginary arrays of size()/2 + 1
+ * bins, which keeps multiplying spectra a simple, vectorizable loop.
+ * The transforms are not normalized: inverse(forward(x)) yields size() * x.
+ *
+ * Construction and resize() allocate, the transforms do not.
+ */
+class fft
+{
+	std::size_t _size = 0; //!< number of real samples
+	std::vector<data> _cos, _sin; //!< twiddles of the complex fft
+	std::vector<data> _rcos, _rsin; //!< twiddles to split the real fft
+	std::vector<std::size_t> _rev; //!< bit reversal permutation
+
+	static constexpr double pi = 3.14159265358979323846;
+
+	//! in-place complex fft of size() / 2 points
+	void complex_fft(data* re, data* im, bool inverse) const
+	{
+		const std::size_t m = _size / 2;
+		for(std::size_t i = 0; i < m; ++i)
+		if(i < _rev[i])
+		{
+			std::swap(re[i], re[_rev[i]]);
+			std::swap(im[i], im[_rev[i]]);
+		}
+		const data sign = inverse ? 1 : -1;
+		for(std::size_t len = 2; len <= m; len <<= 1)
+		{
+			const std::size_t half = len / 2, step = m / len;
+			for(std::size_t start = 0; start < m; start += len)
+			for(std::size_t j = 0; j < half; ++j)
+			{
+				const data wr = _cos[j * step];
+				const data wi = sign * _sin[j * step];
+				const std::size_t a = start + j, b = a + half;
+				const data tr = re[b] * wr - im[b] * wi;
+				const data ti = re[b] * wi + im[b] * wr;
+				re[b] = re[a] - tr;
+				im[b] = im[a] - ti;
+				re[a] += tr;
+				im[a] += ti;
+			}
+		}
+	}
+
+public:
+	fft() {}
+	explicit fft(std::size_t size) { resize(size); }
+
+	//! @param size number of real samples, a power of 2, at least 4
+	void resize(std::size_t size)
+	{
+		assert(size >= 4 && !(size & (size - 1)));
+		_size = size;
+		const std::size_t m = size / 2;
+		_cos.resize(m / 2);
+		_sin.resize(m / 2);
+		for(std::size_t j = 0; j < m / 2; ++j)
+		{
+			_cos[j] = (data)std::cos(2 * pi * j / m);
+			_sin[j] = (data)std::sin(2 * pi * j / m);
+		}
+		_rcos.resize(m / 2 + 1);
+		_rsin.resize(m / 2 + 1);
+		for(std::size_t k = 0; k <= m / 2; ++k)
+		{
+			_rcos[k] = (data)std::cos(2 * pi * k / size);
+			_rsin[k] = (data)-std::sin(2 * pi * k / size);
+		}
+		_rev.resize(m);
+		std::size_t bits = 0;
+		while(((std::size_t)1 << bits) < m)
+			++bits;
+		for(std::size_t i = 0; i < m; ++i)
+		{
+			std::size_t r = 0;
+			for(std::size_t b = 0; b < bits; ++b)
+				r |= ((i >> b) & 1) << (bits - 1 - b);
+			_rev[i] = r;
+		}
+	}
+
+	//! number of real samples
+	std::size_t size() const { return _size; }
+	//! number of complex bins of a spectrum
+	std::size_t bins() const { return _size / 2 + 1; }
+
+	//! Transforms size() samples from @a in into bins() bins
+	void forward(const data* in, data* re, data* im) const
+	{
+		const std::size_t m = _size / 2;
+		// even samples as real, odd ones as imaginary part
+		for(std::size_t i = 0; i < m; ++i)
+		{
+			re[i] = in[2 * i];
+			im[i] = in[2 * i + 1];
+		}
+		complex_fft(re, im, false);
+
+		const data r0 = re[0], i0 = im[0];
+		re[0] = r0 + i0;
+		im[0] = 0;
+		re[m] = r0 - i0;
+		im[m] = 0;
+		for(std::size_t k = 1; k <= m / 2; ++k)
+		{
+			// e = (Z[k] + conj Z[m-k]) / 2, o = (Z[k] - conj Z[m-k]) / 2i
+			const std::size_t l = m - k;
+			const data er = (re[k] + re[l]) / 2, ei = (im[k] - im[l]) / 2;
+			const data or_ = (im[k] + im[l]) / 2, oi = (re[l] - re[k]) / 2;
+			const data tr = _rcos[k] * or_ - _rsin[k] * oi;
+			const data ti = _rcos[k] * oi + _rsin[k] * or_;
+			re[k] = er + tr;
+			im[k] = ei + ti;
+			re[l] = er - tr;
+			im[l] = ti - ei;
+		}
+	}
+
+	//! Transforms bins() bins into size() samples, scaled by size()
+	//! @note This overwrites @a re and @a im
+	void inverse(data* re, data* im, data* out) const
+	{
+		const std::size_t m = _size / 2;
+		const data r0 = re[0], rm = re[m];
+		re[0] = r0 + rm;
+		im[0] = r0 - rm;
+		for(std::size_t k = 1; k <= m / 2; ++k)
+		{
+			// e = X[k] + conj X[m-k], o = (X[k] - conj X[m-k]) conj W^k
+			const std::size_t l = m - k;
+			const data er = re[k] + re[l], ei = im[k] - im[l];
+			const data dr = re[k] - re[l], di = im[k] + im[l];
+			const data or_ = dr * _rcos[k] + di * _rsin[k];
+			const data oi = di * _rcos[k] - dr * _rsin[k];
+			// Z[k] = e + i o, Z[m-k] = conj e + i conj o
+			re[k] = er - oi;
+			im[k] = ei + or_;
+			re[l] = er + oi;
+			im[l] = or_ - ei;
+		}
+		complex_fft(re, im, true);
+		for(std::size_t i = 0; i < m; ++i)
+		{
+			out[2 * i] = re[i];
+			out[2 * i + 1] = im[i];
+		}
+	}
+};
+
+}
+
+#endif // LADSPAPP_FFT_H
@@ -0,0 +1,257 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+
+#ifndef LADSPAPP_FRAME_ADAPTER_H
+#define LADSPAPP_FRAME_ADAPTER_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "../ladspa++.h"
+
+namespace ladspa
+{
+
+/**
+ * @brief Runs frame based code, like spectral processing, on host blocks
+ *   of any size.
+ *
+ * Every @a Hop samples, the callback gets the last @a Frame input samples
+ * of each channel, multiplied by the analysis window, and writes @a Frame
+ * output samples. These are multiplied by the synthesis window and
+ * overlap-added. The windows are normalized, so a callback that copies its
+ * input reproduces the signal, delayed by latency() samples. Report that
+ * value through a port_info_common::latency port.
+ *
+ * Without windowing, frames which lie completely inside the host's input
+ * block are passed to the callback in place, and the input buffering only
+ * copies the samples that later frames need.
+ *
+ * The object holds all buffers itself, so it never allocates, and it is
+ * only used from the audio thread, so it needs no locks.
+ */
+template<std::size_t Frame, std::size_t Hop, std::size_t Channels = 1>
+class frame_adapter
+{
+	static_assert(Hop > 0 && Hop <= Frame && Frame % Hop == 0,
+		"The frame size must be a multiple of the hop size.");
+
+	static constexpr std::size_t ring_size(std::size_t res = 1) {
+		return res >= 2 * Frame ? res : ring_size(res << 1);
+	}
+	static constexpr std::size_t ring_mask = ring_size() - 1;
+
+	//! input, contiguous, so frames can be read from it directly
+	data _history[Channels][2 * Frame];
+	//! overlap-added output, indexed by the output sample's time
+	data _ring[Channels][ring_size()];
+	data _frame_in[Channels][Frame], _frame_out[Channels][Frame];
+	data _analysis[Frame], _synthesis[Frame];
+
+	bool _windowed;
+	bool _in_place; //!< whether frames may be read from the host block
+	std::size_t _hist_pos; //!< end of the history
+	std::size_t _fill; //!< input samples since the last frame
+	std::size_t _time; //!< number of input samples so far (wraps)
+
+	void append_history(const data* const* in, std::size_t from,
+		std::size_t to)
+	{
+		const std::size_t n = to - from;
+		if(_hist_pos + n > 2 * Frame)
+		{
+			// keep the last frame
+			for(std::size_t c = 0; c < Channels; ++c)
+				std::memmove(_history[c], _history[c] + _hist_pos - Frame,
+					Frame * sizeof(data));
+			_hist_pos = Frame;
+		}
+		for(std::size_t c = 0; c < Channels; ++c)
+			std::memcpy(_history[c] + _hist_pos, in[c] + from,
+				n * sizeof(data));
+		_hist_pos += n;
+	}
+
+	//! stores the samples [from, to) of a host block of @a n samples
+	void buffer_input(const data* const* in, std::size_t from,
+		std::size_t to, std::size_t n)
+	{
+		// frames that start in the previous block need the first frame's
+		// worth of samples, the next block needs the last one. in large
+		// blocks, frames in between are read in place
+		if(!_in_place || n <= 2 * Frame)
+			append_history(in, from, to);
+		else
+		{
+			if(from < Frame)
+				append_history(in, from, std::min(to, Frame));
+			if(to > n - Frame)
+			{
+				const std::size_t start = std::max(from, n - Frame);
+				if(start == n - Frame)
+					_hist_pos = 0; // skipped samples, start anew
+				append_history(in, start, to);
+			}
+		}
+	}
+
+	//! runs the frame which ends before sample @a end of the host block
+	template<class F>
+	void run_frame(const data* const* in, std::size_t end, F& callback)
+	{
+		const data* frame[Channels];
+		for(std::size_t c = 0; c < Channels; ++c)
+		{
+			frame[c] = (_in_place && end >= Frame)
+				? in[c] + end - Frame
+				: _history[c] + _hist_pos - Frame;
+			if(_windowed)
+			{
+				for(std::size_t i = 0; i < Frame; ++i)
+					_frame_in[c][i] = frame[c][i] * _analysis[i];
+				frame[c] = _frame_in[c];
+			}
+		}
+		data* out[Channels];
+		for(std::size_t c = 0; c < Channels; ++c)
+			out[c] = _frame_out[c];
+
+		callback(static_cast<const data* const*>(frame),
+			static_cast<data* const*>(out));
+
+		// the frame's first sample is output with the current one
+		const std::size_t start = (_time - 1) & ring_mask;
+		const std::size_t first = std::min(Frame, ring_size() - start);
+		for(std::size_t c = 0; c < Channels; ++c)
+		{
+			data* const ring = _ring[c];
+			for(std::size_t i = 0; i < first; ++i)
+				ring[start + i] += _frame_out[c][i] * _synthesis[i];
+			for(std::size_t i = first; i < Frame; ++i)
+				ring[i - first] += _frame_out[c][i] * _synthesis[i];
+		}
+	}
+
+public:
+	//! @param windowed Whether to use square root Hann windows,
+	//!   otherwise, rectangular ones. Windows need overlapping frames.
+	explicit frame_adapter(bool windowed = Hop < Frame) :
+		_windowed(windowed)
+	{
+		assert(!windowed || Hop < Frame);
+		const double pi = 3.14159265358979323846;
+		for(std::size_t i = 0; i < Frame; ++i)
+			_analysis[i] = _synthesis[i] = windowed
+				? (data)std::sin(pi * i / Frame) : 1;
+		// divide by the sum of the overlapping windows
+		for(std::size_t r = 0; r < Hop; ++r)
+		{
+			double sum = 0;
+			for(std::size_t i = r; i < Frame; i += Hop)
+				sum += _analysis[i] * _synthesis[i];
+			for(std::size_t i = r; i < Frame; i += Hop)
+				_synthesis[i] = sum ? (data)(_synthesis[i] / sum) : 0;
+		}
+		reset();
+	}
+
+	//! Delay between input and output, in samples
+	static constexpr std::size_t latency() { return Frame - 1; }
+	static constexpr std::size_t frame_size() { return Frame; }
+	static constexpr std::size_t hop_size() { return Hop; }
+
+	//! Clears all buffered samples, call it from activate()
+	void reset()
+	{
+		std::memset(_history, 0, sizeof(_history));
+		std::memset(_ring, 0, sizeof(_ring));
+		_hist_pos = Frame;
+		_fill = _time = 0;
+	}
+
+	/**
+	 * Processes @a n samples of each channel.
+	 * @param callback Called as callback(const data* const* in,
+	 *   data* const* out) for each frame, with @a Frame samples for each
+	 *   of the @a Channels channels. @a out has undefined contents.
+	 * @note @a in and @a out may be equal.
+	 */
+	template<class F>
+	void process(const data* const* in, data* const* out, std::size_t n,
+		F callback)
+	{
+		// the output overwrites input that frames might still read
+		_in_place = !_windowed;
+		for(std::size_t c = 0; c < Channels; ++c)
+			_in_place = _in_place && in[c] != out[c];
+
+		for(std::size_t done = 0; done < n; )
+		{
+			const std::size_t cur = std::min(n - done, Hop - _fill);
+			buffer_input(in, done, done + cur, n);
+			_fill += cur;
+			_time += cur;
+			if(_fill == Hop)
+			{
+				_fill = 0;
+				run_frame(in, done + cur, callback);
+			}
+
+			const std::size_t start = (_time - cur) & ring_mask;
+			const std::size_t first = std::min(cur, ring_size() - start);
+			for(std::size_t c = 0; c < Channels; ++c)
+			{
+				data* const ring = _ring[c];
+				data* const dest = out[c] + done;
+				std::memcpy(dest, ring + start, first * sizeof(data));
+				std::memcpy(dest + first, ring, (cur - first) * sizeof(data));
+				std::memset(ring + start, 0, first * sizeof(data));
+				std::memset(ring, 0, (cur - first) * sizeof(data));
+			}
+			done += cur;
+		}
+	}
+
+	//! Mono version, calls callback(const data* in, data* out)
+	template<class F>
+	void process(const data* in, data* out, std::size_t n, F callback)
+	{
+		static_assert(Channels == 1, "Use the multi channel version.");
+		process(&in, &out, n, [&](const data* const* i, data* const* o) {
+			callback(i[0], o[0]); });
+	}
+
+	template<class F>
+	void process(const const_buffer& in, buffer& out, F callback) {
+		process(in.data(), out.data(), out.size(), callback);
+	}
+
+	template<class F>
+	void process(const port_group_template<const_buffer, Channels>& in,
+		port_group_template<buffer, Channels>& out, F callback) {
+		process(in.data(), out.data(), out.sample_count(), callback);
+	}
+};
+
+}
+
+#endif // LADSPAPP_FRAME_ADAPTER_H
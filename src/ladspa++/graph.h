@@ -0,0 +1,664 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+
+#ifndef LADSPAPP_GRAPH_H
+#define LADSPAPP_GRAPH_H
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "control_defaults.h"
+
+namespace ladspa
+{
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+namespace helpers
+{
+
+/*
+ * Fixed size work stealing deque of node indices, after Chase and Lev, with
+ * the memory orders of Le et al. ("Correct and Efficient Work-Stealing for
+ * Weak Memory Models"). Only the owner pushes and pops, at the bottom, the
+ * other threads steal at the top. It never grows, so the capacity must be
+ * at least the number of nodes that can be queued at once.
+ */
+class node_deque
+{
+	std::atomic<std::int64_t> _top{0};
+	std::atomic<std::int64_t> _bottom{0};
+	std::unique_ptr<std::atomic<std::uint32_t>[]> _slots;
+	std::int64_t _mask = 0;
+
+public:
+	static constexpr std::uint32_t empty = std::uint32_t(-1);
+
+	explicit node_deque(std::size_t capacity)
+	{
+		std::size_t size = 1;
+		while(size < capacity)
+			size <<= 1;
+		_slots.reset(new std::atomic<std::uint32_t>[size]);
+		_mask = (std::int64_t)size - 1;
+	}
+
+	//! owner only
+	void push(std::uint32_t node)
+	{
+		const std::int64_t b = _bottom.load(std::memory_order_relaxed);
+		// release, so thieves see what happened before the push
+		_slots[b & _mask].store(node, std::memory_order_release);
+		std::atomic_thread_fence(std::memory_order_release);
+		_bottom.store(b + 1, std::memory_order_relaxed);
+	}
+
+	//! owner only, returns the newest node or empty
+	std::uint32_t pop()
+	{
+		const std::int64_t b = _bottom.load(std::memory_order_relaxed) - 1;
+		_bottom.store(b, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		std::int64_t t = _top.load(std::memory_order_relaxed);
+		std::uint32_t res = empty;
+		if(t <= b)
+		{
+			res = _slots[b & _mask].load(std::memory_order_relaxed);
+			if(t == b)
+			{
+				// the last node, race against the thieves
+				if(!_top.compare_exchange_strong(t, t + 1,
+					std::memory_order_seq_cst,
+					std::memory_order_relaxed))
+					res = empty;
+				_bottom.store(b + 1, std::memory_order_relaxed);
+			}
+		}
+		else
+			_bottom.store(b + 1, std::memory_order_relaxed);
+		return res;
+	}
+
+	//! any thread, returns the oldest node or empty
+	std::uint32_t steal()
+	{
+		std::int64_t t = _top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		const std::int64_t b = _bottom.load(std::memory_order_acquire);
+		if(t >= b)
+			return empty;
+		const std::uint32_t res
+			= _slots[t & _mask].load(std::memory_order_acquire);
+		return _top.compare_exchange_strong(t, t + 1,
+			std::memory_order_seq_cst, std::memory_order_relaxed)
+			? res : empty;
+	}
+};
+
+}
+#endif // DOXYGEN_SHOULD_SKIP_THIS
+
+/**
+ * @brief Runs a directed acyclic graph of plugin instances, block by block.
+ *
+ * Build the graph with add(), connect(), add_input() and add_output(),
+ * then call compile() once, and run() once per cycle. Nodes are
+ * instances of any LADSPA descriptor, including those of
+ * collection<...>::get_ladspa_descriptor().
+ *
+ * Buffers: each input port reads at most one output port, so mix with a
+ * plugin if you need more. Unconnected audio inputs read silence.
+ * compile() assigns the audio outputs to a pool of block sized buffers,
+ * and a buffer is reused as soon as all readers of its previous output
+ * are guaranteed to be done, i.e. are ancestors of the writing node.
+ * This holds for serial and parallel runs alike, so a chain of any
+ * length needs only two buffers. Graph inputs and outputs have buffers
+ * of their own, which are never reused.
+ *
+ * Scheduling: with more than one thread, each cycle is run by the
+ * calling thread and the workers. Each node counts its unfinished
+ * predecessors atomically, and the thread finishing the last one queues
+ * the node on its own lock-free deque. Idle threads steal from the
+ * others. Nothing in run() allocates or locks, except for waking
+ * workers which have slept since the last cycle, because the cycles were
+ * far apart. The workers spin a little after each cycle, so for hosts
+ * running back to back cycles, they never sleep.
+ *
+ * Deadline: each cycle is timed against the duration of its block, or
+ * the deadline set by set_deadline(), and misses are counted in stats().
+ * A late cycle is still run to the end, since skipping nodes would only
+ * trade the late block for a broken one.
+ *
+ * @note All member functions, except run() and the buffer accessors,
+ *   must be called from one thread, and not while run() is running.
+ */
+class graph
+{
+public:
+	typedef std::size_t node_id;
+	//! returned by add() if the instance could not be created
+	static constexpr node_id npos = node_id(-1);
+
+	//! Timing of the cycles run so far
+	struct cycle_stats
+	{
+		std::uint64_t cycles = 0;
+		std::uint64_t deadline_misses = 0;
+		double worst_ns = 0; //!< longest cycle
+	};
+
+private:
+	struct node
+	{
+		const LADSPA_Descriptor* d;
+		LADSPA_Handle handle;
+		std::vector<data> controls; //!< by port, only control ports used
+		std::vector<node_id> successors;
+		std::uint32_t predecessors;
+	};
+
+	//! audio port (@a to, @a in) reads output (@a from, @a out)
+	struct link
+	{
+		node_id from;
+		port_size_t out;
+		node_id to;
+		port_size_t in;
+	};
+
+	//! audio input port (@a to, @a in) reads graph input @a input
+	struct input_link
+	{
+		std::size_t input;
+		node_id to;
+		port_size_t in;
+	};
+
+	struct output_port
+	{
+		node_id from;
+		port_size_t out;
+	};
+
+	const sample_rate_t _rate;
+	const sample_size_t _max_block;
+	const unsigned _threads;
+	//! samples per buffer, rounded up to whole cache lines
+	const std::size_t _stride;
+
+	std::vector<node> _nodes;
+	std::vector<link> _links;
+	std::vector<input_link> _input_links;
+	std::vector<output_port> _outputs;
+	std::size_t _inputs = 0;
+	bool _compiled = false;
+
+	std::vector<node_id> _order; //!< topological
+	std::vector<node_id> _sources; //!< nodes without predecessors
+	std::vector<data> _storage;
+	data* _buffers = nullptr; //!< aligned start of _storage
+	std::size_t _pooled = 0; //!< number of reused buffers
+
+	std::chrono::nanoseconds _deadline{0};
+	cycle_stats _stats;
+
+	/*
+	 * parallel runs
+	 */
+	std::unique_ptr<std::atomic<std::uint32_t>[]> _pending;
+	std::vector<std::unique_ptr<helpers::node_deque>> _deques;
+	std::vector<std::thread> _workers;
+	std::atomic<std::size_t> _remaining{0}; //!< nodes left in this cycle
+	std::atomic<sample_size_t> _samples{0}; //!< of this cycle
+	std::atomic<std::uint64_t> _cycle{0};
+	std::atomic<unsigned> _sleepers{0};
+	std::atomic<bool> _stop{false};
+	std::mutex _sleep_mutex;
+	std::condition_variable _wake;
+
+	//! cycles a worker spins before it sleeps
+	static constexpr unsigned spin_limit = 4096;
+
+	data* buffer(std::size_t index) const
+	{
+		return _buffers + index * _stride;
+	}
+
+	bool is_port(node_id n, port_size_t p, LADSPA_PortDescriptor dir) const
+	{
+		if(n >= _nodes.size() || p >= _nodes[n].d->PortCount)
+			return false;
+		const LADSPA_PortDescriptor pd = _nodes[n].d->PortDescriptors[p];
+		return LADSPA_IS_PORT_AUDIO(pd) && (pd & dir);
+	}
+
+	//! whether input port (@a to, @a in) is already connected
+	bool is_connected(node_id to, port_size_t in) const
+	{
+		for(const link& l : _links)
+		if(l.to == to && l.in == in)
+			return true;
+		for(const input_link& l : _input_links)
+		if(l.to == to && l.in == in)
+			return true;
+		return false;
+	}
+
+	//! sorts the nodes topologically, false if there is a cycle
+	bool sort()
+	{
+		std::vector<std::uint32_t> left(_nodes.size());
+		for(std::size_t i = 0; i < _nodes.size(); ++i)
+		if(!(left[i] = _nodes[i].predecessors))
+			_sources.push_back(i);
+		_order = _sources;
+		for(std::size_t i = 0; i < _order.size(); ++i)
+		for(node_id s : _nodes[_order[i]].successors)
+		if(!--left[s])
+			_order.push_back(s);
+		return _order.size() == _nodes.size();
+	}
+
+	//! assigns each audio output port a buffer index, see the class docs
+	std::vector<std::vector<std::size_t>> assign_buffers()
+	{
+		const std::size_t n = _nodes.size(), words = (n + 63) / 64;
+
+		// ancestors, as one bit set per node
+		std::vector<std::uint64_t> anc(n * words, 0);
+		for(node_id i : _order)
+		for(node_id s : _nodes[i].successors)
+		{
+			for(std::size_t w = 0; w < words; ++w)
+				anc[s * words + w] |= anc[i * words + w];
+			anc[s * words + i / 64] |= std::uint64_t(1) << (i % 64);
+		}
+		auto is_ancestor = [&](node_id a, node_id of) {
+			return (anc[of * words + a / 64] >> (a % 64)) & 1; };
+
+		// who must be done before the buffer of (node, port) is free:
+		// its readers, or the writer itself if nobody reads it
+		auto done_before = [&](node_id from, port_size_t out, node_id q) {
+			bool read = false;
+			for(const link& l : _links)
+			if(l.from == from && l.out == out)
+			{
+				read = true;
+				if(!is_ancestor(l.to, q))
+					return false;
+			}
+			return read || is_ancestor(from, q);
+		};
+
+		// buffer indices: graph inputs, graph outputs, silence, pool
+		const std::size_t pool_start = _inputs + _outputs.size() + 1;
+		std::vector<std::vector<std::size_t>> res(n);
+		std::vector<output_port> owners; // of the pooled buffers
+		for(node_id q : _order)
+		{
+			const LADSPA_Descriptor* d = _nodes[q].d;
+			res[q].assign(d->PortCount, 0);
+			for(port_size_t p = 0; p < d->PortCount; ++p)
+			if(is_port(q, p, LADSPA_PORT_OUTPUT))
+			{
+				std::size_t o = 0;
+				for(; o < _outputs.size(); ++o)
+				if(_outputs[o].from == q && _outputs[o].out == p)
+					break;
+				if(o < _outputs.size())
+				{
+					res[q][p] = _inputs + o;
+					continue;
+				}
+
+				std::size_t b = 0;
+				for(; b < owners.size(); ++b)
+				if(done_before(owners[b].from, owners[b].out, q))
+					break;
+				if(b == owners.size())
+					owners.push_back({ q, p });
+				else
+					owners[b] = { q, p };
+				res[q][p] = pool_start + b;
+			}
+		}
+		_pooled = owners.size();
+		return res;
+	}
+
+	//! runs node @a i, and queues its ready successors on deque @a w
+	void execute(node_id i, unsigned w)
+	{
+		node& nd = _nodes[i];
+		nd.d->run(nd.handle, _samples.load(std::memory_order_relaxed));
+		for(node_id s : nd.successors)
+		if(_pending[s].fetch_sub(1, std::memory_order_acq_rel) == 1)
+			_deques[w]->push((std::uint32_t)s);
+		_remaining.fetch_sub(1, std::memory_order_release);
+	}
+
+	//! takes part in the current cycle until all nodes are done
+	void work(unsigned w)
+	{
+		while(_remaining.load(std::memory_order_acquire))
+		{
+			std::uint32_t i = _deques[w]->pop();
+			for(unsigned k = 1; i == helpers::node_deque::empty
+				&& k < _threads; ++k)
+				i = _deques[(w + k) % _threads]->steal();
+			if(i != helpers::node_deque::empty)
+				execute(i, w);
+			else
+				std::this_thread::yield();
+		}
+	}
+
+	void worker(unsigned w)
+	{
+		std::uint64_t seen = 0;
+		for(;;)
+		{
+			std::uint64_t now;
+			for(unsigned spins = 0;
+				(now = _cycle.load(std::memory_order_acquire)) == seen;
+				++spins)
+			{
+				if(_stop.load(std::memory_order_acquire))
+					return;
+				if(spins < spin_limit)
+					std::this_thread::yield();
+				else
+				{
+					std::unique_lock<std::mutex> lock(_sleep_mutex);
+					++_sleepers;
+					_wake.wait(lock, [&]() {
+						return _stop || _cycle != seen; });
+					--_sleepers;
+				}
+			}
+			seen = now;
+			work(w);
+		}
+	}
+
+	void run_parallel(sample_size_t n)
+	{
+		_samples.store(n, std::memory_order_relaxed);
+		for(std::size_t i = 0; i < _nodes.size(); ++i)
+			_pending[i].store(_nodes[i].predecessors,
+				std::memory_order_relaxed);
+		_remaining.store(_nodes.size(), std::memory_order_relaxed);
+		// the calling thread owns deque 0, and the workers may still be
+		// leaving the last cycle, so never push to their deques
+		for(node_id s : _sources)
+			_deques[0]->push((std::uint32_t)s);
+		// seq_cst, paired with the workers going to sleep
+		++_cycle;
+		if(_sleepers)
+		{
+			std::lock_guard<std::mutex> lock(_sleep_mutex);
+			_wake.notify_all();
+		}
+		work(0);
+	}
+
+public:
+	/**
+	 * @param rate sample rate for all instances
+	 * @param max_block the most samples run() will be called with
+	 * @param threads threads running each cycle, including the caller
+	 */
+	graph(sample_rate_t rate, sample_size_t max_block, unsigned threads = 1)
+		: _rate(rate), _max_block(max_block),
+		_threads(threads ? threads : 1),
+		_stride((max_block + 15) & ~sample_size_t(15))
+	{
+	}
+
+	graph(const graph&) = delete;
+	graph& operator=(const graph&) = delete;
+
+	//! Stops the workers, deactivates and destroys all instances
+	~graph()
+	{
+		_stop = true;
+		{
+			std::lock_guard<std::mutex> lock(_sleep_mutex);
+		}
+		_wake.notify_all();
+		for(std::thread& t : _workers)
+			t.join();
+		for(node& nd : _nodes)
+		{
+			if(_compiled && nd.d->deactivate)
+				nd.d->deactivate(nd.handle);
+			nd.d->cleanup(nd.handle);
+		}
+	}
+
+	//! Adds an instance of @a d, with all control inputs at their
+	//! defaults, and returns its id, or npos if it can not be created
+	node_id add(const LADSPA_Descriptor* d)
+	{
+		LADSPA_Handle h = _compiled ? nullptr : d->instantiate(d, _rate);
+		if(!h)
+			return npos;
+		node nd = { d, h, std::vector<data>(d->PortCount, 0), {}, 0 };
+		for(port_size_t p = 0; p < d->PortCount; ++p)
+		if(LADSPA_IS_PORT_CONTROL(d->PortDescriptors[p]))
+		{
+			nd.controls[p] = default_control_value(
+				d->PortRangeHints[p], _rate);
+			d->connect_port(h, p, &nd.controls[p]);
+		}
+		// moving keeps the controls where they are
+		_nodes.push_back(std::move(nd));
+		return _nodes.size() - 1;
+	}
+
+	//! Sets control input @a port of node @a n, between cycles
+	void set_control(node_id n, port_size_t port, data value)
+	{
+		_nodes[n].controls[port] = value;
+	}
+
+	//! The value of control output @a port of node @a n, between cycles
+	data control_output(node_id n, port_size_t port) const
+	{
+		return _nodes[n].controls[port];
+	}
+
+	//! Lets audio input @a in of node @a to read audio output @a out of
+	//! node @a from. Returns false if the ports are no such ports, or the
+	//! input is already connected.
+	bool connect(node_id from, port_size_t out, node_id to, port_size_t in)
+	{
+		if(_compiled || !is_port(from, out, LADSPA_PORT_OUTPUT)
+			|| !is_port(to, in, LADSPA_PORT_INPUT)
+			|| is_connected(to, in))
+			return false;
+		_links.push_back({ from, out, to, in });
+		return true;
+	}
+
+	//! Adds an audio input of the graph, and returns its index
+	std::size_t add_input() { return _inputs++; }
+
+	//! Lets audio input @a in of node @a to read graph input @a input
+	bool connect_input(std::size_t input, node_id to, port_size_t in)
+	{
+		if(_compiled || input >= _inputs
+			|| !is_port(to, in, LADSPA_PORT_INPUT) || is_connected(to, in))
+			return false;
+		_input_links.push_back({ input, to, in });
+		return true;
+	}
+
+	//! Makes audio output @a out of node @a from an output of the
+	//! graph, and returns its index, or npos if it is no such port
+	std::size_t add_output(node_id from, port_size_t out)
+	{
+		if(_compiled || !is_port(from, out, LADSPA_PORT_OUTPUT))
+			return npos;
+		for(std::size_t o = 0; o < _outputs.size(); ++o)
+		if(_outputs[o].from == from && _outputs[o].out == out)
+			return o;
+		_outputs.push_back({ from, out });
+		return _outputs.size() - 1;
+	}
+
+	/**
+	 * @brief Assigns the buffers, connects and activates all instances,
+	 *   and starts the worker threads.
+	 * @return false if the graph has a cycle, or compile() was called
+	 *   before
+	 */
+	bool compile()
+	{
+		if(_compiled)
+			return false;
+		for(const link& l : _links)
+		{
+			std::vector<node_id>& succ = _nodes[l.from].successors;
+			if(std::find(succ.begin(), succ.end(), l.to) == succ.end())
+			{
+				succ.push_back(l.to);
+				++_nodes[l.to].predecessors;
+			}
+		}
+		if(!sort())
+			return false;
+
+		const std::vector<std::vector<std::size_t>> out = assign_buffers();
+		const std::size_t silence = _inputs + _outputs.size();
+		const std::size_t count = silence + 1 + _pooled;
+		// one extra cache line, to align the start
+		_storage.assign(count * _stride + 16, 0);
+		_buffers = _storage.data();
+		while((std::uintptr_t)_buffers % 64)
+			++_buffers;
+
+		for(node_id i = 0; i < _nodes.size(); ++i)
+		{
+			const node& nd = _nodes[i];
+			for(port_size_t p = 0; p < nd.d->PortCount; ++p)
+			if(is_port(i, p, LADSPA_PORT_OUTPUT))
+				nd.d->connect_port(nd.handle, p, buffer(out[i][p]));
+			else if(is_port(i, p, LADSPA_PORT_INPUT))
+				nd.d->connect_port(nd.handle, p, buffer(silence));
+		}
+		for(const link& l : _links)
+			_nodes[l.to].d->connect_port(_nodes[l.to].handle, l.in,
+				buffer(out[l.from][l.out]));
+		for(const input_link& l : _input_links)
+			_nodes[l.to].d->connect_port(_nodes[l.to].handle, l.in,
+				buffer(l.input));
+
+		for(node& nd : _nodes)
+		if(nd.d->activate)
+			nd.d->activate(nd.handle);
+		_compiled = true;
+
+		if(_threads > 1)
+		{
+			_pending.reset(new std::atomic<std::uint32_t>[_nodes.size()]);
+			for(unsigned w = 0; w < _threads; ++w)
+				_deques.emplace_back(
+					new helpers::node_deque(_nodes.size()));
+			for(unsigned w = 1; w < _threads; ++w)
+				_workers.emplace_back(&graph::worker, this, w);
+		}
+		return true;
+	}
+
+	//! Sets the time one cycle may take, or 0 (the default) for the
+	//! duration of its block
+	void set_deadline(std::chrono::nanoseconds deadline)
+	{
+		_deadline = deadline;
+	}
+
+	/**
+	 * @brief Runs all nodes once, on @a n samples.
+	 *
+	 * Fill the graph inputs before, and read the graph outputs after.
+	 * @param n at most the max_block given to the constructor
+	 * @return false if the cycle missed its deadline
+	 */
+	bool run(sample_size_t n)
+	{
+		assert(n <= _max_block);
+		typedef std::chrono::steady_clock clock;
+		const clock::time_point start = clock::now();
+		if(_workers.empty())
+		{
+			for(node_id i : _order)
+				_nodes[i].d->run(_nodes[i].handle, n);
+		}
+		else
+			run_parallel(n);
+		const std::chrono::nanoseconds took = clock::now() - start;
+
+		const std::chrono::nanoseconds deadline = _deadline.count()
+			? _deadline : std::chrono::nanoseconds(
+				(std::int64_t)(n * 1e9 / _rate));
+		const bool in_time = took <= deadline;
+		++_stats.cycles;
+		_stats.deadline_misses += !in_time;
+		_stats.worst_ns = std::max(_stats.worst_ns, (double)took.count());
+		return in_time;
+	}
+
+	//! Buffer of graph input @a input, for the next cycle, only valid
+	//! after compile()
+	data* input(std::size_t input) { return buffer(input); }
+
+	//! Buffer of graph output @a output, after a cycle
+	const data* output(std::size_t output) const
+	{
+		return buffer(_inputs + output);
+	}
+
+	//! Number of nodes
+	std::size_t size() const { return _nodes.size(); }
+
+	//! Number of pooled buffers, which is at most the number of
+	//! audio outputs that are no graph outputs
+	std::size_t pooled_buffers() const { return _pooled; }
+
+	//! Number of threads running each cycle
+	unsigned threads() const { return _threads; }
+
+	//! Timing of the cycles run so far
+	const cycle_stats& stats() const { return _stats; }
+};
+
+}
+
+#endif // LADSPAPP_GRAPH_H
@@ -0,0 +1,163 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#ifndef LADSPAPP_HISTORY_WINDOW_H
+#define LADSPAPP_HISTORY_WINDOW_H
+
+#include <cstring>
+
+#include "../ladspa++.h"
+
+namespace ladspa
+{
+
+/**
+ * @brief Gives kernels the last @a History input samples before each
+ *   sample, across block boundaries.
+ *
+ * FIR filters, differentiators or lookahead detectors read in[i - k]. The
+ * callback gets pointers @a x with x[i - k] valid for all k < @a History,
+ * so it needs neither a ring buffer nor any bounds checks:
+ * @code
+ * history_window<taps> window; // plugin member, reset() in activate()
+ * window.process(in, out, [&](const data* x, data* y, std::size_t n) {
+ * 	for(std::size_t i = 0; i < n; ++i)
+ * 		y[i] = h[0] * x[i];
+ * 	for(std::size_t k = 1; k < taps; ++k) // vectorized over i:
+ * 	for(std::size_t i = 0; i < n; ++i)
+ * 		y[i] += h[k] * x[i - k];
+ * });
+ * @endcode
+ * Each block is passed in two parts: the first History - 1 samples are
+ * copied behind the stored tail of the previous blocks, and the rest is
+ * read from the host's buffer directly. Only if the output is the input
+ * (in place processing), the whole block is copied, in chunks, since the
+ * output would overwrite samples that the callback still reads.
+ *
+ * The object holds all buffers itself, so it never allocates.
+ */
+template<std::size_t History, std::size_t Channels = 1>
+class history_window
+{
+	static_assert(History >= 1, "The history must contain the sample "
+		"itself.");
+
+	//! samples before the current one
+	static constexpr std::size_t tail = History - 1;
+	//! samples copied at once when processing in place
+	static constexpr std::size_t chunk = (tail > 256) ? tail : 256;
+
+	//! the last @a tail input samples, followed by space for new ones
+	data _buffer[Channels][tail + chunk];
+
+	//! copies @a n <= chunk input samples behind the tail, calls the
+	//! callback on them, and makes the last @a tail samples the new tail
+	template<class F>
+	void staged(const data* const* in, data* const* out, std::size_t from,
+		std::size_t n, F& callback)
+	{
+		const data* x[Channels];
+		data* y[Channels];
+		for(std::size_t c = 0; c < Channels; ++c)
+		{
+			std::memcpy(_buffer[c] + tail, in[c] + from,
+				n * sizeof(data));
+			x[c] = _buffer[c] + tail;
+			y[c] = out[c] + from;
+		}
+		callback(x, y, n);
+		for(std::size_t c = 0; c < Channels; ++c)
+			std::memmove(_buffer[c], _buffer[c] + n, tail * sizeof(data));
+	}
+
+public:
+	history_window() { reset(); }
+
+	//! Number of samples that x[i - k] can reach back, plus one
+	static constexpr std::size_t history() { return History; }
+
+	//! Sets the history to zero, call it from activate()
+	void reset() { std::memset(_buffer, 0, sizeof(_buffer)); }
+
+	/**
+	 * Processes @a n samples of each channel.
+	 * @param callback Called as callback(const data* const* x,
+	 *   data* const* out, std::size_t count), once or a few times per
+	 *   block. x[c][i - k] is valid for i < count and k < @a History.
+	 * @note @a in and @a out may be equal, but must not overlap otherwise.
+	 */
+	template<class F>
+	void process(const data* const* in, data* const* out, std::size_t n,
+		F callback)
+	{
+		bool in_place = false;
+		for(std::size_t c = 0; c < Channels; ++c)
+			in_place = in_place || in[c] == out[c];
+
+		if(in_place)
+		{
+			for(std::size_t done = 0; done < n; done += chunk)
+				staged(in, out, done,
+					(n - done < chunk) ? n - done : chunk, callback);
+			return;
+		}
+
+		const std::size_t head = (n < tail) ? n : tail;
+		staged(in, out, 0, head, callback);
+		if(n > head)
+		{
+			const data* x[Channels];
+			data* y[Channels];
+			for(std::size_t c = 0; c < Channels; ++c)
+			{
+				x[c] = in[c] + head;
+				y[c] = out[c] + head;
+			}
+			callback(x, y, n - head);
+			for(std::size_t c = 0; c < Channels; ++c)
+				std::memcpy(_buffer[c], in[c] + n - tail,
+					tail * sizeof(data));
+		}
+	}
+
+	//! Mono version, calls callback(const data* x, data* out, count)
+	template<class F>
+	void process(const data* in, data* out, std::size_t n, F callback)
+	{
+		static_assert(Channels == 1, "Use the multi channel version.");
+		process(&in, &out, n, [&](const data* const* x, data* const* y,
+			std::size_t count) { callback(x[0], y[0], count); });
+	}
+
+	template<class F>
+	void process(const const_buffer& in, buffer& out, F callback) {
+		process(in.data(), out.data(), out.size(), callback);
+	}
+
+	template<class F>
+	void process(const port_group_template<const_buffer, Channels>& in,
+		port_group_template<buffer, Channels>& out, F callback) {
+		process(in.data(), out.data(), out.sample_count(), callback);
+	}
+};
+
+}
+
+#endif // LADSPAPP_HISTORY_WINDOW_H
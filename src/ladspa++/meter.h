@@ -0,0 +1,458 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#ifndef LADSPAPP_METER_H
+#define LADSPAPP_METER_H
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+#include "../ladspa++.h"
+#include "biquad.h"
+
+namespace ladspa
+{
+
+/*
+ * Reductions over blocks of samples
+ *
+ * The sums use independent accumulators, so the compiler can vectorize
+ * them. Minimum and maximum are not vectorized by compilers without
+ * -ffast-math, so they use SSE if it is available.
+ */
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+namespace helpers
+{
+	//! number of independent accumulators
+	constexpr std::size_t reduce_lanes = 8;
+
+#ifdef __SSE__
+	inline data horizontal_max(__m128 v)
+	{
+		v = _mm_max_ps(v, _mm_movehl_ps(v, v));
+		v = _mm_max_ss(v, _mm_shuffle_ps(v, v, 1));
+		return _mm_cvtss_f32(v);
+	}
+
+	inline data horizontal_min(__m128 v)
+	{
+		v = _mm_min_ps(v, _mm_movehl_ps(v, v));
+		v = _mm_min_ss(v, _mm_shuffle_ps(v, v, 1));
+		return _mm_cvtss_f32(v);
+	}
+#endif
+}
+#endif /* DOXYGEN_SHOULD_SKIP_THIS */
+
+//! Returns the maximum of |x[i]|, or 0 if @a n is 0
+inline data max_abs(const data* x, std::size_t n)
+{
+	std::size_t i = 0;
+	data res = 0;
+#ifdef __SSE__
+	const __m128 sign = _mm_set1_ps(-0.0f);
+	__m128 m0 = _mm_setzero_ps(), m1 = _mm_setzero_ps();
+	for(; i + 8 <= n; i += 8)
+	{
+		m0 = _mm_max_ps(m0, _mm_andnot_ps(sign, _mm_loadu_ps(x + i)));
+		m1 = _mm_max_ps(m1, _mm_andnot_ps(sign, _mm_loadu_ps(x + i + 4)));
+	}
+	res = helpers::horizontal_max(_mm_max_ps(m0, m1));
+#endif
+	for(; i < n; ++i)
+		res = std::max(res, std::fabs(x[i]));
+	return res;
+}
+
+//! Computes the minimum and maximum of @a x, both 0 if @a n is 0
+inline void min_max(const data* x, std::size_t n, data& lo, data& hi)
+{
+	if(!n)
+	{
+		lo = hi = 0;
+		return;
+	}
+	std::size_t i = 0;
+	lo = hi = x[0];
+#ifdef __SSE__
+	__m128 l = _mm_set1_ps(x[0]), h = l;
+	for(; i + 4 <= n; i += 4)
+	{
+		const __m128 v = _mm_loadu_ps(x + i);
+		l = _mm_min_ps(l, v);
+		h = _mm_max_ps(h, v);
+	}
+	lo = helpers::horizontal_min(l);
+	hi = helpers::horizontal_max(h);
+#endif
+	for(; i < n; ++i)
+	{
+		lo = std::min(lo, x[i]);
+		hi = std::max(hi, x[i]);
+	}
+}
+
+//! Returns the sum of x[i] * y[i]
+inline data dot(const data* x, const data* y, std::size_t n)
+{
+	constexpr std::size_t lanes = helpers::reduce_lanes;
+	const std::size_t blocked = n - n % lanes;
+	data acc[lanes] = {};
+	for(std::size_t i = 0; i < blocked; i += lanes)
+	for(std::size_t k = 0; k < lanes; ++k)
+		acc[k] += x[i + k] * y[i + k];
+	for(std::size_t i = blocked; i < n; ++i)
+		acc[0] += x[i] * y[i];
+	data res = 0;
+	for(std::size_t k = 0; k < lanes; ++k)
+		res += acc[k];
+	return res;
+}
+
+//! Returns the sum of x[i]^2
+inline data sum_of_squares(const data* x, std::size_t n)
+{
+	return dot(x, x, n);
+}
+
+inline data max_abs(const const_buffer& x) {
+	return max_abs(x.data(), x.size());
+}
+inline void min_max(const const_buffer& x, data& lo, data& hi) {
+	min_max(x.data(), x.size(), lo, hi);
+}
+inline data dot(const const_buffer& x, const const_buffer& y) {
+	return dot(x.data(), y.data(), std::min(x.size(), y.size()));
+}
+inline data sum_of_squares(const const_buffer& x) {
+	return sum_of_squares(x.data(), x.size());
+}
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+namespace helpers
+{
+
+/**
+ * Ballistics and decimation of the meters.
+ *
+ * Every block is reduced, so no peak or energy is missed. With a
+ * decimation of N, the reductions of N blocks are collected, and the
+ * ballistics only run on every N-th block, for the time that has passed
+ * since they last ran. The value in between stays the same.
+ */
+class meter_base
+{
+	double _time_ms;
+	double _k = 0; //!< 1 / (time constant in samples)
+	std::size_t _decimation = 1, _skipped = 0;
+	std::size_t _elapsed = 0; //!< samples since the ballistics last ran
+
+protected:
+	meter_base(double rate, double time_ms) : _time_ms(time_ms) {
+		set_rate(rate);
+	}
+
+	//! Counts the block, returns true iff the ballistics shall run
+	bool measure(std::size_t n)
+	{
+		_elapsed += n;
+		if(++_skipped < _decimation)
+			return false;
+		_skipped = 0;
+		return true;
+	}
+
+	//! Factor of the old value, for the time since the ballistics last ran
+	data decay()
+	{
+		const data res = (data)std::exp(-(double)_elapsed * _k);
+		_elapsed = 0;
+		return res;
+	}
+
+	void restart() { _skipped = _elapsed = 0; }
+
+public:
+	void set_rate(double rate) {
+		_k = _time_ms > 0 ? 1000 / (_time_ms * rate) : 1e30;
+	}
+
+	//! Run the ballistics only every @a blocks-th block
+	void set_decimation(std::size_t blocks) {
+		_decimation = std::max<std::size_t>(blocks, 1);
+	}
+};
+
+}
+#endif /* DOXYGEN_SHOULD_SKIP_THIS */
+
+/**
+ * @brief Peak meter with instant attack and exponential release.
+ *
+ * Call process() once per run(), and pass the output control port.
+ */
+class peak_meter : public helpers::meter_base
+{
+	data _value = 0;
+	data _peak = 0; //!< since the ballistics last ran
+public:
+	//! @param release_ms time to fall to 1/e of the peak
+	explicit peak_meter(double rate = 44100, double release_ms = 300)
+		: meter_base(rate, release_ms) {}
+
+	void reset() { _value = _peak = 0; restart(); }
+	//! the current (linear) peak
+	data value() const { return _value; }
+
+	void process(const data* in, std::size_t n)
+	{
+		_peak = std::max(_peak, max_abs(in, n));
+		if(measure(n))
+		{
+			_value = std::max(_peak, _value * decay());
+			_peak = 0;
+		}
+	}
+
+	void process(const const_buffer& in, data& out)
+	{
+		process(in.data(), in.size());
+		out = _value;
+	}
+};
+
+/**
+ * @brief RMS meter with an exponential integration time.
+ */
+class rms_meter : public helpers::meter_base
+{
+	data _mean_square = 0;
+	data _sum = 0; //!< of the squares since the ballistics last ran
+	std::size_t _count = 0; //!< samples in _sum
+public:
+	explicit rms_meter(double rate = 44100, double integration_ms = 300)
+		: meter_base(rate, integration_ms) {}
+
+	void reset() { _mean_square = _sum = 0; _count = 0; restart(); }
+	//! the current (linear) RMS
+	data value() const { return std::sqrt(_mean_square); }
+
+	void process(const data* in, std::size_t n)
+	{
+		if(!n)
+			return;
+		_sum += sum_of_squares(in, n);
+		_count += n;
+		if(measure(n))
+		{
+			const data d = decay();
+			_mean_square = _mean_square * d + _sum / _count * (1 - d);
+			_sum = 0;
+			_count = 0;
+		}
+	}
+
+	void process(const const_buffer& in, data& out)
+	{
+		process(in.data(), in.size());
+		out = value();
+	}
+};
+
+/**
+ * @brief Correlation of two channels, in [-1, 1].
+ *
+ * 1 means mono, 0 means unrelated channels, and -1 means opposite phases.
+ * Silence reads as 1.
+ */
+class correlation_meter : public helpers::meter_base
+{
+	data _lr = 0, _ll = 0, _rr = 0;
+	//! sums since the ballistics last ran
+	data _sum_lr = 0, _sum_ll = 0, _sum_rr = 0;
+	std::size_t _count = 0;
+public:
+	explicit correlation_meter(double rate = 44100,
+		double integration_ms = 300)
+		: meter_base(rate, integration_ms) {}
+
+	void reset()
+	{
+		_lr = _ll = _rr = _sum_lr = _sum_ll = _sum_rr = 0;
+		_count = 0;
+		restart();
+	}
+
+	data value() const
+	{
+		const data energy = std::sqrt(_ll * _rr);
+		return energy > 1e-12f
+			? std::max((data)-1, std::min((data)1, _lr / energy))
+			: 1;
+	}
+
+	void process(const data* l, const data* r, std::size_t n)
+	{
+		if(!n)
+			return;
+		_sum_lr += dot(l, r, n);
+		_sum_ll += sum_of_squares(l, n);
+		_sum_rr += sum_of_squares(r, n);
+		_count += n;
+		if(measure(n))
+		{
+			const data d = decay(), w = (1 - d) / _count;
+			_lr = _lr * d + _sum_lr * w;
+			_ll = _ll * d + _sum_ll * w;
+			_rr = _rr * d + _sum_rr * w;
+			_sum_lr = _sum_ll = _sum_rr = 0;
+			_count = 0;
+		}
+	}
+
+	void process(const const_buffer& l, const const_buffer& r, data& out)
+	{
+		process(l.data(), r.data(), std::min(l.size(), r.size()));
+		out = value();
+	}
+};
+
+/**
+ * @brief Momentary loudness of @a Channels channels, in LUFS.
+ *
+ * The channels are K-weighted and summed with equal weights (i.e. without
+ * the surround weights), over a window of 400 ms, which is updated every
+ * 100 ms. The filters need every sample, so there is no decimation.
+ */
+template<std::size_t Channels = 1>
+class loudness_meter
+{
+	static constexpr std::size_t chunk = 256;
+	static constexpr std::size_t windows = 4; //!< 100 ms each
+
+	biquad_cascade<2> weighting[Channels];
+	std::size_t _step = 4410; //!< samples per 100 ms
+	std::size_t _pos = 0; //!< samples in the current 100 ms
+	double _sum = 0; //!< of the current 100 ms
+	double _window[windows] = {}; //!< mean squares of the last 400 ms
+	std::size_t _window_pos = 0;
+	data _value = -70;
+
+	void finish_step()
+	{
+		_window[_window_pos] = _sum / _step;
+		_window_pos = (_window_pos + 1) % windows;
+		double mean = 0;
+		for(double w : _window)
+			mean += w / windows;
+		_value = (data)(-0.691 + 10 * std::log10(std::max(mean, 1e-10)));
+		_sum = 0;
+		_pos = 0;
+	}
+
+public:
+	explicit loudness_meter(double rate = 44100) { set_rate(rate); }
+
+	void set_rate(double rate)
+	{
+		// the ITU-R BS.1770 pre-filter and RLB filter, designed for any
+		// rate (at 48 kHz, they match the coefficients of the standard)
+		const double pi = 3.14159265358979323846;
+		double k = std::tan(pi * 1681.974450955533 / rate);
+		double q = 0.7071752369554196;
+		const double vh = std::pow(10.0, 3.999843853973347 / 20);
+		const double vb = std::pow(vh, 0.4996667741545416);
+		double a0 = 1 + k / q + k * k;
+		const biquad_coeffs pre = { (data)((vh + vb * k / q + k * k) / a0),
+			(data)(2 * (k * k - vh) / a0),
+			(data)((vh - vb * k / q + k * k) / a0),
+			(data)(2 * (k * k - 1) / a0),
+			(data)((1 - k / q + k * k) / a0) };
+		k = std::tan(pi * 38.13547087602444 / rate);
+		q = 0.5003270373238773;
+		a0 = 1 + k / q + k * k;
+		const biquad_coeffs rlb = { 1, -2, 1,
+			(data)(2 * (k * k - 1) / a0),
+			(data)((1 - k / q + k * k) / a0) };
+		for(biquad_cascade<2>& w : weighting)
+		{
+			w.set(0, pre);
+			w.set(1, rlb);
+		}
+		_step = std::max<std::size_t>((std::size_t)(rate / 10), 1);
+		reset();
+	}
+
+	void reset()
+	{
+		for(biquad_cascade<2>& w : weighting)
+			w.reset();
+		std::fill(_window, _window + windows, 0.0);
+		_window_pos = _pos = 0;
+		_sum = 0;
+		_value = -70;
+	}
+
+	//! the loudness of the last 400 ms, in LUFS
+	data value() const { return _value; }
+
+	void process(const data* const* in, std::size_t n)
+	{
+		data weighted[chunk];
+		for(std::size_t done = 0; done < n; )
+		{
+			const std::size_t cur = std::min(std::min(chunk, n - done),
+				_step - _pos);
+			for(std::size_t c = 0; c < Channels; ++c)
+			{
+				weighting[c].process(in[c] + done, weighted, cur);
+				_sum += sum_of_squares(weighted, cur);
+			}
+			done += cur;
+			if((_pos += cur) == _step)
+				finish_step();
+		}
+	}
+
+	void process(const port_group_template<const_buffer, Channels>& in,
+		data& out)
+	{
+		process(in.data(), in.sample_count());
+		out = _value;
+	}
+
+	//! for one channel
+	void process(const const_buffer& in, data& out)
+	{
+		static_assert(Channels == 1, "Pass all channels.");
+		const data* ptr = in.data();
+		process(&ptr, in.size());
+		out = _value;
+	}
+};
+
+}
+
+#endif // LADSPAPP_METER_H
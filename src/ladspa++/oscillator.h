@@ -0,0 +1,299 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#ifndef LADSPAPP_OSCILLATOR_H
+#define LADSPAPP_OSCILLATOR_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "../ladspa++.h"
+#include "shared_resource.h"
+
+namespace ladspa
+{
+
+//! Waveforms of the built-in wavetables
+enum class waveform
+{
+	sine,
+	saw, //!< rising from -1 to 1
+	square,
+	triangle
+};
+
+/**
+ * @brief Band-limited wavetables of one waveform, one per octave.
+ *
+ * Each table holds one cycle of table_size samples. Table @a l contains
+ * the harmonics up to max_harmonic >> l, so a tone whose frequency is at
+ * most 1 / (2 * (max_harmonic >> l)) cycles per sample can be played from
+ * it without aliasing. Below that, the top octave of a tone can lack some
+ * harmonics, which is the usual price of one table per octave.
+ *
+ * The tables are built once, by additive synthesis, so use get() to share
+ * them between all instances.
+ * @note Saw and square peak at about +-1.18 (Gibbs phenomenon).
+ */
+class wavetable
+{
+public:
+	//! log2 of table_size
+	static constexpr unsigned size_bits = 11;
+	//! samples per cycle
+	static constexpr std::size_t table_size = std::size_t(1) << size_bits;
+	//! number of tables
+	static constexpr unsigned levels = 10;
+	//! highest harmonic in table 0, which leaves 4 times oversampling
+	//! for the interpolation
+	static constexpr unsigned max_harmonic = 1u << (levels - 1);
+
+private:
+	//! all tables, each followed by a copy of its first sample, so that
+	//! interpolation needs no wrap around
+	std::vector<data> _samples;
+
+	//! amplitude of the sine of harmonic @a k
+	static double amplitude(waveform shape, unsigned k)
+	{
+		const double pi = 3.14159265358979323846;
+		switch(shape)
+		{
+			case waveform::sine:
+				return k == 1;
+			case waveform::saw:
+				return -2 / (pi * k);
+			case waveform::square:
+				return (k % 2) ? 4 / (pi * k) : 0;
+			case waveform::triangle:
+				return (k % 2) ? ((k % 4 == 1) ? 8 : -8)
+					/ (pi * pi * k * k) : 0;
+		}
+		return 0;
+	}
+
+public:
+	explicit wavetable(waveform shape)
+		: _samples(levels * (table_size + 1))
+	{
+		const std::size_t n = table_size;
+		std::vector<double> sines(n), acc(n, 0.0);
+		for(std::size_t i = 0; i < n; ++i)
+			sines[i] = std::sin(2 * 3.14159265358979323846 * i / n);
+
+		// from the top table down, each one adds the harmonics of
+		// the next octave to the previous one
+		unsigned k = 1;
+		for(unsigned l = levels; l-- > 0; )
+		{
+			for(; k <= (max_harmonic >> l); ++k)
+			{
+				const double a = amplitude(shape, k);
+				if(a != 0)
+					for(std::size_t i = 0; i < n; ++i)
+						acc[i] += a * sines[(k * i) & (n - 1)];
+			}
+			data* t = &_samples[l * (n + 1)];
+			std::copy(acc.begin(), acc.end(), t);
+			t[n] = t[0];
+		}
+	}
+
+	//! Returns the shared tables of @a shape
+	//! @note Not realtime safe, see shared_resource
+	static std::shared_ptr<const wavetable> get(waveform shape) {
+		return shared_resource<wavetable, waveform>::get(shape);
+	}
+
+	//! Samples of table @a l, table_size + 1 of them
+	const data* table(unsigned l) const {
+		return &_samples[l * (table_size + 1)];
+	}
+
+	/**
+	 * @brief Selects the table for a phase increment.
+	 * @param increment the phase increment per sample, where 2^32 is
+	 *   one cycle, at most 2^31 (the Nyquist frequency)
+	 * @return the table with the most harmonics that does not alias
+	 */
+	static unsigned level_for(std::uint32_t increment)
+	{
+		// table l is fine up to 2^(22 + l), i.e. half a cycle per
+		// (max_harmonic >> l)-th of a cycle
+		unsigned l = 0;
+		while(l + 1 < levels
+			&& increment > (std::uint32_t(1) << (32 - size_bits + 1 + l)))
+			++l;
+		return l;
+	}
+};
+
+/**
+ * @brief An oscillator which plays band-limited wavetables.
+ *
+ * The phase is a 32 bit fixed point number, so it wraps around without
+ * any checks, and the samples are interpolated linearly. The oscillator
+ * works on chunks of 64 samples: phases and interpolation are computed in
+ * vectorized loops, only the table lookups are done one by one.
+ *
+ * The frequency is either a scalar, e.g. from a control port, or the sum
+ * of a scalar and an audio rate FM input in Hz. Negative frequencies run
+ * backwards (through-zero FM). Frequencies beyond the Nyquist frequency
+ * are clamped.
+ * @code
+ * oscillator osc(waveform::saw, sample_rate); // in the constructor
+ * osc.process(ports.get<freq>(), ports.get<out>()); // in run()
+ * @endcode
+ */
+class oscillator
+{
+	static constexpr std::size_t chunk = 64;
+	static constexpr unsigned frac_bits = 32 - wavetable::size_bits;
+
+	std::shared_ptr<const wavetable> _tables;
+	double _rate;
+	//! 2^32 / sample rate
+	data _scale;
+	std::uint32_t _phase = 0;
+
+	//! phase increment for @a cycles, in 2^-32 cycles per sample,
+	//! clamped to +-0.5 cycles per sample
+	static std::uint32_t increment(data cycles)
+	{
+		const data limit = 2147483520.0f; // the float below 2^31
+		cycles = std::max(-limit, std::min(limit, cycles));
+		return (std::uint32_t)(std::int32_t)cycles;
+	}
+
+	static std::uint32_t magnitude(std::uint32_t increment) {
+		return (increment >> 31) ? 0u - increment : increment;
+	}
+
+	//! looks up and interpolates @a n <= chunk samples at @a phases
+	static void interpolate(const data* t, const std::uint32_t* phases,
+		data* out, std::size_t n)
+	{
+		const data to_frac = 1.0f / (std::uint32_t(1) << frac_bits);
+		const std::uint32_t frac_mask = (std::uint32_t(1) << frac_bits) - 1;
+		data a[chunk], b[chunk];
+		for(std::size_t j = 0; j < n; ++j)
+		{
+			const data* s = t + (phases[j] >> frac_bits);
+			a[j] = s[0];
+			b[j] = s[1];
+		}
+		for(std::size_t j = 0; j < n; ++j)
+		{
+			const data frac = (data)(std::int32_t)
+				(phases[j] & frac_mask) * to_frac;
+			out[j] = a[j] + (b[j] - a[j]) * frac;
+		}
+	}
+
+public:
+	//! @note Not realtime safe, since it looks up the tables
+	explicit oscillator(waveform shape = waveform::sine,
+		double rate = 44100)
+		: _tables(wavetable::get(shape)) { set_rate(rate); }
+
+	//! @note Not realtime safe, since it looks up the tables
+	void set_waveform(waveform shape) { _tables = wavetable::get(shape); }
+	//! Switches to tables which the plugin holds, realtime safe
+	void set_tables(const std::shared_ptr<const wavetable>& tables) {
+		_tables = tables;
+	}
+
+	void set_rate(double rate) {
+		_rate = rate;
+		_scale = 4294967296.0 / rate;
+	}
+	double rate() const { return _rate; }
+
+	//! Sets the phase, in cycles
+	void reset(double phase = 0) {
+		phase -= std::floor(phase);
+		_phase = (std::uint32_t)(phase * 4294967296.0);
+	}
+	//! The phase, in cycles
+	double phase() const { return _phase / 4294967296.0; }
+
+	//! Renders @a n samples at @a freq Hz
+	void process(data freq, data* out, std::size_t n)
+	{
+		const std::uint32_t inc = increment(freq * _scale);
+		const data* t = _tables->table(
+			wavetable::level_for(magnitude(inc)));
+		std::uint32_t phases[chunk];
+		for(std::size_t i = 0; i < n; i += chunk)
+		{
+			const std::size_t m = (n - i < chunk) ? n - i : chunk;
+			for(std::size_t j = 0; j < m; ++j)
+				phases[j] = _phase + std::uint32_t(j) * inc;
+			_phase += std::uint32_t(m) * inc;
+			interpolate(t, phases, out + i, m);
+		}
+	}
+
+	/**
+	 * @brief Renders @a n samples at @a freq + @a fm[i] Hz.
+	 *
+	 * The table is selected per chunk, by the highest frequency in it. An
+	 * unpatched, i.e. constant, @a fm costs the same as no FM at all.
+	 */
+	void process(data freq, const data* fm, data* out, std::size_t n)
+	{
+		data value;
+		if(is_constant(const_buffer(fm, n), value))
+			return process(freq + value, out, n);
+
+		std::uint32_t incs[chunk], phases[chunk];
+		for(std::size_t i = 0; i < n; i += chunk)
+		{
+			const std::size_t m = (n - i < chunk) ? n - i : chunk;
+			std::uint32_t highest = 0;
+			for(std::size_t j = 0; j < m; ++j)
+			{
+				incs[j] = increment((freq + fm[i + j]) * _scale);
+				highest = std::max(highest, magnitude(incs[j]));
+			}
+			for(std::size_t j = 0; j < m; ++j)
+			{
+				phases[j] = _phase;
+				_phase += incs[j];
+			}
+			interpolate(_tables->table(wavetable::level_for(highest)),
+				phases, out + i, m);
+		}
+	}
+
+	void process(data freq, buffer out) {
+		process(freq, out.data(), out.size());
+	}
+	void process(data freq, const const_buffer& fm, buffer out) {
+		process(freq, fm.data(), out.data(), out.size());
+	}
+};
+
+}
+
+#endif // LADSPAPP_OSCILLATOR_H
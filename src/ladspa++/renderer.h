@@ -0,0 +1,417 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+
+#ifndef LADSPAPP_RENDERER_H
+#define LADSPAPP_RENDERER_H
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <dlfcn.h>
+#include <getopt.h>
+#include <sys/stat.h>
+
+#include "audio_file.h"
+#include "control_defaults.h"
+
+namespace ladspa
+{
+
+//! Settings for rendering files offline
+struct render_options
+{
+	//! samples per run() call
+	std::size_t block_size = 65536;
+	//! sample format of written WAV files
+	audio_file::sample_format format = audio_file::float_32;
+	//! interleaved channels of headerless input files
+	unsigned raw_channels = 1;
+	//! sample rate of headerless input files
+	unsigned raw_rate = 48000;
+	//! values for control input ports, by ladspa port index,
+	//! all others use their default
+	std::vector<std::pair<port_size_t, data>> controls;
+};
+
+/**
+ * @brief Runs one plugin over audio files.
+ *
+ * Use one object per thread. The plugin instances are kept from one file
+ * to the next, and only recreated if the sample rate or the number of
+ * channels changes. Between files, they are deactivated and activated
+ * again, which resets them.
+ *
+ * If the plugin has as many audio inputs as the file has channels, one
+ * instance is used. Plugins with one input get one instance per channel.
+ */
+class renderer
+{
+	const LADSPA_Descriptor* _d;
+	render_options _opts;
+	std::vector<port_size_t> _inputs, _outputs; //!< audio ports
+	std::vector<data> _controls; //!< values of all control ports
+
+	std::vector<LADSPA_Handle> _instances;
+	std::size_t _count = 0; //!< number of instances that _buffers is for
+	sample_rate_t _rate = 0;
+	bool _active = false;
+	//! block_size samples for each input, then for each output channel
+	std::vector<data> _buffers;
+
+	void cleanup()
+	{
+		deactivate();
+		for(LADSPA_Handle h : _instances)
+			_d->cleanup(h);
+		_instances.clear();
+	}
+
+	void deactivate()
+	{
+		if(_active && _d->deactivate)
+			for(LADSPA_Handle h : _instances)
+				_d->deactivate(h);
+		_active = false;
+	}
+
+	//! @return false iff the plugin could not be instantiated
+	bool prepare(std::size_t count, sample_rate_t rate)
+	{
+		deactivate();
+		if(count != _instances.size() || rate != _rate)
+		{
+			cleanup();
+			_count = count;
+			_rate = rate;
+			for(port_size_t p = 0; p < _d->PortCount; ++p)
+			if(LADSPA_IS_PORT_CONTROL(_d->PortDescriptors[p]))
+				_controls[p] = default_control_value(
+					_d->PortRangeHints[p], rate);
+			for(const std::pair<port_size_t, data>& c : _opts.controls)
+				_controls[c.first] = c.second;
+
+			const std::size_t block = _opts.block_size;
+			const std::size_t ins = _inputs.size(), outs = _outputs.size();
+			_buffers.assign((ins + outs) * count * block, 0);
+			for(std::size_t i = 0; i < count; ++i)
+			{
+				LADSPA_Handle h = _d->instantiate(_d, rate);
+				if(!h)
+					return false;
+				_instances.push_back(h);
+				for(port_size_t p = 0; p < _d->PortCount; ++p)
+				if(LADSPA_IS_PORT_CONTROL(_d->PortDescriptors[p]))
+					_d->connect_port(h, p, &_controls[p]);
+				for(std::size_t j = 0; j < ins; ++j)
+					_d->connect_port(h, _inputs[j],
+						input(i * ins + j));
+				for(std::size_t j = 0; j < outs; ++j)
+					_d->connect_port(h, _outputs[j],
+						output(i * outs + j));
+			}
+		}
+		if(_d->activate)
+			for(LADSPA_Handle h : _instances)
+				_d->activate(h);
+		_active = true;
+		return true;
+	}
+
+	data* input(std::size_t channel) {
+		return &_buffers[channel * _opts.block_size];
+	}
+	data* output(std::size_t channel) {
+		return &_buffers[(_inputs.size() * _count + channel)
+			* _opts.block_size];
+	}
+
+public:
+	renderer(const LADSPA_Descriptor* d, const render_options& opts) :
+		_d(d), _opts(opts), _controls(d->PortCount, 0)
+	{
+		for(port_size_t p = 0; p < d->PortCount; ++p)
+		if(LADSPA_IS_PORT_AUDIO(d->PortDescriptors[p]))
+			(LADSPA_IS_PORT_INPUT(d->PortDescriptors[p])
+				? _inputs : _outputs).push_back(p);
+	}
+	renderer(const renderer&) = delete;
+	renderer& operator=(const renderer&) = delete;
+	~renderer() { cleanup(); }
+
+	/**
+	 * Renders the file @a in_path into @a out_path. Output files ending
+	 * with ".raw" are headerless, all others are WAV files.
+	 * @return false iff something failed, see @a error
+	 */
+	bool render(const char* in_path, const char* out_path,
+		std::string& error)
+	{
+		// writing the input's own file would truncate it while it is
+		// still mapped
+		struct stat in_st, out_st;
+		if(stat(in_path, &in_st) == 0 && stat(out_path, &out_st) == 0
+			&& in_st.st_dev == out_st.st_dev
+			&& in_st.st_ino == out_st.st_ino)
+			return error = "the output file is the input file", false;
+
+		audio_file in;
+		if(!in.open(in_path, _opts.raw_channels))
+			return error = "can not read input file", false;
+		in.file().advise_sequential();
+
+		const std::size_t channels = in.channels();
+		std::size_t count;
+		if(_inputs.size() == channels)
+			count = 1;
+		else if(_inputs.size() == 1)
+			count = channels;
+		else
+			return error = "the plugin's audio inputs do not match "
+				"the file's channels", false;
+		const sample_rate_t rate = in.rate() ? in.rate() : _opts.raw_rate;
+
+		if(!prepare(count, rate))
+			return error = "can not instantiate the plugin", false;
+
+		const std::size_t out_channels = count * _outputs.size();
+		const std::size_t len = std::strlen(out_path);
+		const bool raw = len >= 4 && !std::strcmp(out_path + len - 4, ".raw");
+		if(!raw && !audio_file_writer::fits(in.frames(), out_channels,
+			_opts.format))
+			return error = "the output is too large for a WAV file, "
+				"use a .raw file", false;
+		audio_file_writer out;
+		if(!out.open(out_path, out_channels, rate, _opts.format, raw))
+			return error = "can not create output file", false;
+
+		std::vector<data*> ins(channels), outs(out_channels);
+		for(std::size_t c = 0; c < channels; ++c)
+			ins[c] = input(c);
+		for(std::size_t c = 0; c < out_channels; ++c)
+			outs[c] = output(c);
+
+		for(std::size_t pos = 0; pos < in.frames(); )
+		{
+			const std::size_t n = std::min(_opts.block_size,
+				in.frames() - pos);
+			in.read_frames(pos, n, ins.data());
+			for(LADSPA_Handle h : _instances)
+				_d->run(h, n);
+			if(!out.write(outs.data(), n))
+				return error = "can not write output file", false;
+			pos += n;
+			in.file().drop_before(in.offset(pos));
+		}
+		deactivate();
+		if(!out.close())
+			return error = "can not write output file", false;
+		return true;
+	}
+};
+
+/**
+ * Renders all pairs of input and output files of @a jobs on @a threads
+ * threads, with one renderer per thread. Errors are printed to stderr.
+ * @return the number of files that failed
+ */
+inline std::size_t render_files(const LADSPA_Descriptor* d,
+	const render_options& opts,
+	const std::vector<std::pair<std::string, std::string>>& jobs,
+	unsigned threads)
+{
+	std::atomic<std::size_t> next(0), failed(0);
+	std::mutex print_mutex;
+	auto work = [&]() {
+		renderer r(d, opts);
+		std::string error;
+		for(std::size_t i; (i = next++) < jobs.size(); )
+		if(!r.render(jobs[i].first.c_str(), jobs[i].second.c_str(), error))
+		{
+			++failed;
+			std::lock_guard<std::mutex> lock(print_mutex);
+			std::fprintf(stderr, "%s: %s\n", jobs[i].first.c_str(),
+				error.c_str());
+		}
+	};
+	std::vector<std::thread> pool;
+	for(unsigned t = 1; t < threads && t < jobs.size(); ++t)
+		pool.emplace_back(work);
+	work();
+	for(std::thread& t : pool)
+		t.join();
+	return failed;
+}
+
+/**
+ * The command line interface of the renderer. Run it with "-h" for help.
+ *
+ * To render with plugins that are linked into the program, pass their
+ * collection:
+ * @code
+ * int main(int argc, char** argv) {
+ * 	return ladspa::render_main(argc, argv,
+ * 		ladspa::collection<my_plugin>::get_ladspa_descriptor);
+ * }
+ * @endcode
+ * Otherwise, the plugin library must be given with "-p".
+ */
+inline int render_main(int argc, char** argv,
+	LADSPA_Descriptor_Function linked = nullptr)
+{
+	const char* usage =
+		"usage: %s [options] -o <output dir> <input files...>\n"
+		"  -p <file>         plugin library to load\n"
+		"  -l <label>        plugin label (default: the first plugin)\n"
+		"  -i <index>        plugin index in the library\n"
+		"  -c <port>=<value> control port value, port by index or name\n"
+		"  -b <samples>      block size (default: 65536)\n"
+		"  -j <threads>      parallel files (default: all cores)\n"
+		"  -s <threads>      threads per block of stateless plugins\n"
+		"                    (default: 1)\n"
+		"  -f <format>       WAV output format: 16, 24, 32 or float\n"
+		"  -C <channels>     channels of headerless input files\n"
+		"  -r <rate>         sample rate of headerless input files\n"
+		"Output files get the input file names, and are headerless\n"
+		"32 bit float files iff their name ends with \".raw\".\n";
+
+	render_options opts;
+	const char *lib = nullptr, *label = nullptr, *out_dir = nullptr;
+	unsigned long index = 0;
+	unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+	std::vector<std::pair<std::string, std::string>> controls;
+	for(int opt; (opt = getopt(argc, argv, "p:l:i:c:b:j:s:f:C:r:o:h")) != -1; )
+	switch(opt)
+	{
+		case 'p': lib = optarg; break;
+		case 'l': label = optarg; break;
+		case 'i': index = std::strtoul(optarg, nullptr, 10); break;
+		case 'c':
+		{
+			const char* eq = std::strchr(optarg, '=');
+			if(!eq)
+				return std::fprintf(stderr, usage, argv[0]), EXIT_FAILURE;
+			controls.emplace_back(std::string(optarg, eq - optarg), eq + 1);
+			break;
+		}
+		case 'b':
+			opts.block_size = std::max(1ul, std::strtoul(optarg, nullptr, 10));
+			break;
+		case 'j':
+			threads = std::max(1ul, std::strtoul(optarg, nullptr, 10));
+			break;
+		case 's':
+			// read by work_pool::offline(), in the plugin library
+			setenv("LADSPAPP_THREADS", optarg, 1);
+			break;
+		case 'f':
+			opts.format = !std::strcmp(optarg, "16") ? audio_file::pcm_16
+				: !std::strcmp(optarg, "24") ? audio_file::pcm_24
+				: !std::strcmp(optarg, "32") ? audio_file::pcm_32
+				: audio_file::float_32;
+			break;
+		case 'C':
+			opts.raw_channels = std::strtoul(optarg, nullptr, 10);
+			break;
+		case 'r': opts.raw_rate = std::strtoul(optarg, nullptr, 10); break;
+		case 'o': out_dir = optarg; break;
+		default:
+			std::fprintf(stderr, usage, argv[0]);
+			return (opt == 'h') ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+	if(!out_dir || optind == argc || (!lib && !linked))
+		return std::fprintf(stderr, usage, argv[0]), EXIT_FAILURE;
+
+	LADSPA_Descriptor_Function get_descriptor = linked;
+	if(lib)
+	{
+		// the library stays loaded until the program ends
+		void* handle = dlopen(lib, RTLD_NOW | RTLD_LOCAL);
+		if(handle)
+			get_descriptor = (LADSPA_Descriptor_Function)
+				dlsym(handle, "ladspa_descriptor");
+		if(!handle || !get_descriptor)
+		{
+			std::fprintf(stderr, "%s\n", dlerror());
+			return EXIT_FAILURE;
+		}
+	}
+
+	const LADSPA_Descriptor* d = nullptr;
+	for(unsigned long i = 0; label && (d = get_descriptor(i)); ++i)
+	if(!std::strcmp(d->Label, label))
+		break;
+	if(!label)
+		d = get_descriptor(index);
+	if(!d)
+	{
+		std::fprintf(stderr, "plugin not found\n");
+		return EXIT_FAILURE;
+	}
+
+	for(const std::pair<std::string, std::string>& c : controls)
+	{
+		port_size_t p = 0;
+		while(p < d->PortCount && c.first != d->PortNames[p]
+			&& c.first != std::to_string(p))
+			++p;
+		if(p == d->PortCount || !LADSPA_IS_PORT_CONTROL(d->PortDescriptors[p])
+			|| !LADSPA_IS_PORT_INPUT(d->PortDescriptors[p]))
+		{
+			std::fprintf(stderr, "no control input \"%s\"\n",
+				c.first.c_str());
+			return EXIT_FAILURE;
+		}
+		opts.controls.emplace_back(p, (data)std::atof(c.second.c_str()));
+	}
+
+	std::vector<std::pair<std::string, std::string>> jobs;
+	for(int i = optind; i < argc; ++i)
+	{
+		const char* slash = std::strrchr(argv[i], '/');
+		jobs.emplace_back(argv[i], std::string(out_dir) + '/'
+			+ (slash ? slash + 1 : argv[i]));
+	}
+
+	// inputs of the same name from different directories would all be
+	// written to one file, at the same time with -j
+	std::map<std::string, std::string> inputs_of;
+	for(const std::pair<std::string, std::string>& job : jobs)
+	if(!inputs_of.emplace(job.second, job.first).second)
+	{
+		std::fprintf(stderr, "%s and %s would both be written to %s\n",
+			inputs_of[job.second].c_str(), job.first.c_str(),
+			job.second.c_str());
+		return EXIT_FAILURE;
+	}
+	return render_files(d, opts, jobs, threads) ? EXIT_FAILURE
+		: EXIT_SUCCESS;
+}
+
+}
+
+#endif // LADSPAPP_RENDERER_H
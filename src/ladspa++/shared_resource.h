@@ -0,0 +1,127 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#ifndef LADSPAPP_SHARED_RESOURCE_H
+#define LADSPAPP_SHARED_RESOURCE_H
+
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace ladspa
+{
+
+/**
+ * @brief Read-only data which all instances of a plugin can share, like
+ *   wavetables, windows, filter taps or impulse responses.
+ *
+ * A resource is created by the first instance that asks for it, and freed
+ * when the last instance holding it is cleaned up. Resources are looked up
+ * by a key (e.g. the sample rate, or a std::tuple of parameters), which
+ * needs an operator<.
+ *
+ * Each combination of @a Resource, @a Key and @a Owner has its own cache.
+ * Pass your plugin class as @a Owner if different plugins use the same
+ * resource type with different contents.
+ *
+ * All functions are thread safe, but not realtime safe. Call them in your
+ * plugin's constructor or activate() function, e.g.
+ * @code
+ * my_plugin(sample_rate_t rate)
+ * : table(shared_resource<sine_table>::get(rate)) {}
+ * @endcode
+ */
+template<class Resource, class Key = unsigned long, class Owner = void>
+class shared_resource
+{
+	typedef std::map<Key, std::weak_ptr<const Resource>> map_t;
+
+	//! the mutex and the entries, initialized on first use
+	struct cache
+	{
+		std::mutex mutex;
+		map_t entries;
+
+		//! removes entries of resources which have been freed
+		void prune()
+		{
+			for(typename map_t::iterator itr = entries.begin();
+				itr != entries.end(); )
+			if(itr->second.expired())
+				itr = entries.erase(itr);
+			else
+				++itr;
+		}
+	};
+
+	static cache& instance()
+	{
+		static cache res;
+		return res;
+	}
+
+public:
+	/**
+	 * Returns the resource for @a key, or creates it by calling @a make.
+	 *
+	 * @a make returns a pointer to a new resource (raw, unique_ptr or
+	 * shared_ptr), or nullptr on failure, which is not cached. It is
+	 * called with the cache locked, so each resource is only created once.
+	 */
+	template<class Factory>
+	static std::shared_ptr<const Resource> get(const Key& key, Factory make)
+	{
+		cache& c = instance();
+		std::lock_guard<std::mutex> lock(c.mutex);
+		typename map_t::iterator itr = c.entries.find(key);
+		std::shared_ptr<const Resource> res;
+		if(itr != c.entries.end())
+			res = itr->second.lock();
+		if(!res)
+		{
+			res = std::shared_ptr<const Resource>(make());
+			if(res)
+			{
+				c.prune();
+				c.entries[key] = res;
+			}
+		}
+		return res;
+	}
+
+	//! Returns the resource for @a key, or constructs it as Resource(key)
+	static std::shared_ptr<const Resource> get(const Key& key)
+	{
+		return get(key, [&key]() { return new Resource(key); });
+	}
+
+	//! Number of resources currently alive
+	static std::size_t size()
+	{
+		cache& c = instance();
+		std::lock_guard<std::mutex> lock(c.mutex);
+		c.prune();
+		return c.entries.size();
+	}
+};
+
+}
+
+#endif // LADSPAPP_SHARED_RESOURCE_H
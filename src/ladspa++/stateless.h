@@ -0,0 +1,114 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+
+#ifndef LADSPAPP_STATELESS_H
+#define LADSPAPP_STATELESS_H
+
+#include "../ladspa++.h"
+#include "work_pool.h"
+
+namespace ladspa
+{
+
+/**
+ * @brief Blocks of stateless plugins are split into chunks of at least
+ *   this many samples.
+ *
+ * Plugins which keep no state from one sample to the next, like an
+ * amplifier, can declare in their class
+ * @code
+ * static constexpr bool stateless = true;
+ * @endcode
+ * and include this header. They must not have non-static data members,
+ * control outputs or a variant_port, which is checked at compile time.
+ * Their run() function must not touch any other state, which can not be
+ * checked.
+ *
+ * In offline rendering, blocks of at least twice this size are then split
+ * into chunks, which run in parallel on work_pool::offline(). The chunks
+ * work in place on the host's buffers. By default, there is no such pool,
+ * so realtime hosts are not affected, see work_pool::offline().
+ */
+constexpr sample_size_t stateless_min_chunk = 4096;
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+namespace helpers
+{
+
+/**
+ * Runs a stateless plugin. Large blocks are split into chunks, which run
+ * on the offline work_pool, if there is one. The chunks work on the
+ * host's buffers, with a copy of the port array each.
+ */
+template<class Plugin, class PortArray>
+class stateless_runner
+{
+	typedef audio_port_table<PortArray> audio;
+
+	struct chunk_job
+	{
+		Plugin* plugin;
+		const PortArray* ports;
+		sample_size_t chunk;
+
+		void operator()(std::size_t c) const
+		{
+			PortArray part = *ports;
+			const sample_size_t offset = c * chunk,
+				left = ports->sample_count() - offset;
+			for(port_size_t p = 0; p < PortArray::size(); ++p)
+				if(audio::is_audio[p])
+					part.connect(p, ports->raw_port(p) + offset);
+			part.set_current_sample_count(
+				(left < chunk) ? left : chunk);
+			plugin->run(part);
+		}
+	};
+
+public:
+	void run(Plugin& plugin, PortArray& ports)
+	{
+		const sample_size_t n = ports.sample_count(),
+			min_chunk = stateless_min_chunk;
+		work_pool* pool = (n >= 2 * min_chunk)
+			? work_pool::offline() : nullptr;
+		if(!pool)
+		{
+			plugin.run(ports);
+			return;
+		}
+
+		// about 4 chunks per thread, so that the threads can balance them,
+		// and all chunks start on a 64 byte boundary of the buffers
+		sample_size_t chunks = 4 * (pool->workers() + 1);
+		chunks = (n / min_chunk < chunks) ? n / min_chunk : chunks;
+		const sample_size_t chunk = (n / chunks + 15) & ~sample_size_t(15);
+		chunk_job job = { &plugin, &ports, chunk };
+		pool->parallel_for((n + chunk - 1) / chunk, job);
+	}
+};
+
+}
+#endif /* DOXYGEN_SHOULD_SKIP_THIS */
+
+}
+
+#endif // LADSPAPP_STATELESS_H
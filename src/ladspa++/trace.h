@@ -0,0 +1,501 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#ifndef LADSPAPP_TRACE_H
+#define LADSPAPP_TRACE_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace ladspa
+{
+
+/**
+ * @brief A timeline of all calls into the plugins.
+ *
+ * If ladspa++ is compiled with LADSPAPP_TRACE defined (cmake
+ * -DLADSPAPP_TRACE=ON), each call of instantiate(), connect_port(),
+ * activate(), run(), deactivate() and cleanup() is recorded as one event.
+ * Otherwise, nothing of this is compiled in.
+ *
+ * Each thread writes into its own ring buffer, so recording needs no
+ * locks. The ring buffers live in a memory mapped file, which also
+ * survives crashes. Its path is taken from the environment variable
+ * LADSPAPP_TRACE_FILE, and defaults to /tmp/ladspa++-<pid>.trace.
+ * LADSPAPP_TRACE_THREADS (default 32) and LADSPAPP_TRACE_EVENTS (events
+ * per thread, default 32768) set its size. Once a ring is full, the
+ * oldest events are overwritten, and the converted trace reports how many
+ * were. A thread's ring is given back when the thread exits, so threads
+ * that come and go reuse the rings. Only events of threads which find no
+ * free ring are dropped, and they are counted.
+ *
+ * Each event costs two reads of the time stamp counter and a 32 byte
+ * store. On the virtual machine this was measured on, that was 25 to
+ * 50 ns per event, nearly all of it in the counter reads, which are slow
+ * under virtualization.
+ *
+ * The ladspa_trace tool converts the file to Chrome's trace format.
+ */
+namespace trace
+{
+
+enum class event_type : std::uint32_t
+{
+	instantiate,
+	connect_port,
+	activate,
+	run,
+	deactivate,
+	cleanup
+};
+
+inline const char* name(event_type type)
+{
+	static const char* const names[] = { "instantiate", "connect_port",
+		"activate", "run", "deactivate", "cleanup" };
+	return (std::size_t)type < sizeof(names) / sizeof(names[0])
+		? names[(std::size_t)type] : "unknown";
+}
+
+//! One call
+struct event
+{
+	std::uint64_t start; //!< in ticks, see file_header
+	std::uint32_t duration; //!< in ticks, saturated
+	//! the sample count for run(), the port for connect_port(),
+	//! the sample rate for instantiate()
+	std::uint32_t arg;
+	std::uint32_t unique_id; //!< of the plugin
+	std::uint32_t instance; //!< counted from 1, in order of creation
+	std::uint32_t thread; //!< the kernel's thread id
+	std::uint32_t type; //!< an event_type
+};
+static_assert(sizeof(event) == 32, "Trace events should have 32 bytes.");
+
+constexpr char file_magic[8] = { 'L', 'P', 'P', 'T', 'R', 'A', 'C', 'E' };
+constexpr std::uint32_t file_version = 1;
+
+//! The start of a trace file
+struct alignas(64) file_header
+{
+	char magic[8];
+	std::uint32_t version;
+	std::uint32_t event_size;
+	std::uint32_t rings;
+	std::uint32_t ring_events; //!< capacity of each ring, a power of 2
+	std::uint32_t pid;
+	double ticks_per_us;
+	std::uint64_t first_tick; //!< time 0 of the trace
+	//! rings which ever had an owner, these are the first ones
+	std::atomic<std::uint32_t> rings_used;
+	//! events of threads which found no free ring
+	std::atomic<std::uint64_t> dropped;
+};
+
+//! The start of each ring, followed by its events
+struct alignas(64) ring_header
+{
+	//! number of events ever written, the last one is at
+	//! (written - 1) % ring_events
+	std::atomic<std::uint64_t> written;
+	std::uint32_t thread; //!< the last owner
+	//! 1 while a thread writes into this ring
+	std::atomic<std::uint32_t> owned;
+};
+
+//! offset of ring @a i in the file
+inline std::size_t ring_offset(const file_header& h, std::size_t i)
+{
+	return sizeof(file_header) + i * (sizeof(ring_header)
+		+ (std::size_t)h.ring_events * sizeof(event));
+}
+
+//! The time stamp counter, or a nanosecond clock if there is none
+inline std::uint64_t ticks()
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/**
+ * @brief The trace file of this process.
+ *
+ * It is created on the first use. If that fails, all events are dropped.
+ */
+class recorder
+{
+	file_header* _header = nullptr;
+	std::size_t _bytes = 0;
+	std::atomic<std::uint32_t> _instances{0};
+
+	static std::size_t from_env(const char* name, std::size_t fallback)
+	{
+		const char* str = std::getenv(name);
+		const long res = str ? std::atol(str) : 0;
+		return res > 0 ? (std::size_t)res : fallback;
+	}
+
+	//! measures the ticks per microsecond, in about one millisecond
+	static double calibrate()
+	{
+#if defined(__x86_64__) || defined(__i386__)
+		typedef std::chrono::steady_clock clock;
+		const clock::time_point t0 = clock::now();
+		const std::uint64_t c0 = ticks();
+		clock::time_point t1;
+		do
+			t1 = clock::now();
+		while(t1 - t0 < std::chrono::milliseconds(1));
+		const std::uint64_t c1 = ticks();
+		return (c1 - c0) / std::chrono::duration<double, std::micro>(
+			t1 - t0).count();
+#else
+		return 1000;
+#endif
+	}
+
+	recorder()
+	{
+		const char* env_path = std::getenv("LADSPAPP_TRACE_FILE");
+		const std::string path = env_path ? env_path
+			: "/tmp/ladspa++-" + std::to_string(getpid()) + ".trace";
+		std::size_t ring_events = 1;
+		while(ring_events < from_env("LADSPAPP_TRACE_EVENTS", 32768))
+			ring_events <<= 1;
+
+		file_header h;
+		h.rings = from_env("LADSPAPP_TRACE_THREADS", 32);
+		h.ring_events = ring_events;
+		const std::size_t bytes = ring_offset(h, h.rings);
+
+		const int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC
+			| O_CLOEXEC, 0644);
+		if(fd < 0)
+			return;
+		void* mem = MAP_FAILED;
+		if(ftruncate(fd, bytes) == 0)
+			mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+				MAP_SHARED, fd, 0);
+		close(fd);
+		if(mem == MAP_FAILED)
+			return;
+
+		// the file is zero filled, so all rings are empty
+		_header = static_cast<file_header*>(mem);
+		_bytes = bytes;
+		std::memcpy(_header->magic, file_magic, sizeof(file_magic));
+		_header->version = file_version;
+		_header->event_size = sizeof(event);
+		_header->rings = h.rings;
+		_header->ring_events = h.ring_events;
+		_header->pid = getpid();
+		_header->ticks_per_us = calibrate();
+		_header->first_tick = ticks();
+	}
+
+public:
+	recorder(const recorder&) = delete;
+	recorder& operator=(const recorder&) = delete;
+	~recorder()
+	{
+		if(_header)
+			munmap(_header, _bytes);
+	}
+
+	static recorder& instance()
+	{
+		static recorder res;
+		return res;
+	}
+
+	//! Returns a free ring for thread @a thread, or nullptr
+	ring_header* claim(std::uint32_t thread)
+	{
+		if(!_header)
+			return nullptr;
+		for(std::uint32_t i = 0; i < _header->rings; ++i)
+		{
+			ring_header* res = reinterpret_cast<ring_header*>(
+				reinterpret_cast<char*>(_header)
+				+ ring_offset(*_header, i));
+			std::uint32_t expected = 0;
+			if(res->owned.load(std::memory_order_relaxed)
+				|| !res->owned.compare_exchange_strong(expected, 1,
+					std::memory_order_acquire))
+				continue;
+			res->thread = thread;
+			std::uint32_t used = _header->rings_used.load();
+			while(used < i + 1
+				&& !_header->rings_used.compare_exchange_weak(used, i + 1))
+				;
+			return res;
+		}
+		return nullptr;
+	}
+
+	//! Gives back a ring of claim()
+	void release(ring_header* ring)
+	{
+		ring->owned.store(0, std::memory_order_release);
+	}
+
+	std::uint32_t ring_events() const {
+		return _header ? _header->ring_events : 0;
+	}
+
+	void drop()
+	{
+		if(_header)
+			_header->dropped.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	//! Returns the id for a new instance
+	std::uint32_t next_instance() {
+		return _instances.fetch_add(1, std::memory_order_relaxed) + 1;
+	}
+};
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+namespace helpers
+{
+
+//! The ring of one thread. This is a POD, so the thread local variable
+//! needs no construction and no guard.
+struct writer;
+
+inline writer& this_writer();
+
+//! gives back the ring of its thread when the thread exits. it only
+//! exists for threads which recorded, so writer can stay a POD.
+struct ring_release
+{
+	ring_header* ring = nullptr;
+	~ring_release();
+};
+
+struct writer
+{
+	ring_header* ring;
+	event* events;
+	std::uint64_t mask, written;
+	std::uint32_t thread;
+	bool failed;
+
+	bool open()
+	{
+		if(failed)
+			return false;
+		thread = (std::uint32_t)syscall(SYS_gettid);
+		recorder& r = recorder::instance();
+		ring = r.claim(thread);
+		failed = !ring;
+		if(failed)
+			return false;
+		events = reinterpret_cast<event*>(ring + 1);
+		mask = r.ring_events() - 1;
+		// a reused ring keeps the events of its last owner
+		written = ring->written.load(std::memory_order_relaxed);
+		static thread_local ring_release release;
+		release.ring = ring;
+		return true;
+	}
+};
+
+inline writer& this_writer()
+{
+	static thread_local writer res;
+	return res;
+}
+
+inline ring_release::~ring_release()
+{
+	// events after this, e.g. of other thread local destructors, are
+	// dropped, since the ring may have a new owner
+	writer& w = this_writer();
+	w.events = nullptr;
+	w.failed = true;
+	recorder::instance().release(ring);
+}
+
+}
+#endif /* DOXYGEN_SHOULD_SKIP_THIS */
+
+//! Appends @a e to the calling thread's ring
+inline void record(event& e)
+{
+	helpers::writer& w = helpers::this_writer();
+	if(!w.events && !w.open())
+	{
+		recorder::instance().drop();
+		return;
+	}
+	e.thread = w.thread;
+	w.events[w.written & w.mask] = e;
+	w.ring->written.store(++w.written, std::memory_order_release);
+}
+
+//! Records one event for its lifetime
+class scope
+{
+	event _e;
+public:
+	scope(event_type type, unsigned long unique_id,
+		std::uint32_t instance, unsigned long arg)
+	{
+		_e.type = (std::uint32_t)type;
+		_e.unique_id = (std::uint32_t)unique_id;
+		_e.instance = instance;
+		_e.arg = (std::uint32_t)arg;
+		_e.start = ticks();
+	}
+	scope(const scope&) = delete;
+	scope& operator=(const scope&) = delete;
+
+	//! for instantiate(), where the instance only exists afterwards
+	void set_instance(std::uint32_t instance) { _e.instance = instance; }
+
+	~scope()
+	{
+		const std::uint64_t duration = ticks() - _e.start;
+		_e.duration = duration > UINT32_MAX
+			? UINT32_MAX : (std::uint32_t)duration;
+		record(_e);
+	}
+};
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+namespace helpers
+{
+
+//! calls @a f for all events of the file at @a base, ring by ring,
+//! from the oldest to the newest event
+template<class F>
+void for_each_event(const file_header& h, const char* base, F f)
+{
+	const std::uint32_t rings = std::min(h.rings, h.rings_used.load());
+	for(std::uint32_t i = 0; i < rings; ++i)
+	{
+		const ring_header& r = *reinterpret_cast<const ring_header*>(
+			base + ring_offset(h, i));
+		const event* events = reinterpret_cast<const event*>(&r + 1);
+		const std::uint64_t written = r.written.load(
+			std::memory_order_acquire);
+		const std::uint64_t first = written > h.ring_events
+			? written - h.ring_events : 0;
+		for(std::uint64_t k = first; k < written; ++k)
+			f(events[k & (h.ring_events - 1)]);
+	}
+}
+
+}
+#endif /* DOXYGEN_SHOULD_SKIP_THIS */
+
+/**
+ * Converts the trace file at @a path to Chrome's trace format, which can
+ * be opened in chrome://tracing or Perfetto. Each instance is shown as
+ * one process, and each thread as one thread.
+ * @return false iff the file could not be read
+ */
+inline bool write_chrome_json(const char* path, std::FILE* out)
+{
+	const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+	if(fd < 0)
+		return false;
+	struct stat st;
+	void* mem = MAP_FAILED;
+	if(fstat(fd, &st) == 0 && (std::size_t)st.st_size
+		>= sizeof(file_header))
+		mem = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(mem == MAP_FAILED)
+		return false;
+
+	const file_header& h = *static_cast<const file_header*>(mem);
+	const bool ok = !std::memcmp(h.magic, file_magic, sizeof(file_magic))
+		&& h.version == file_version && h.event_size == sizeof(event)
+		&& h.ring_events
+		&& ring_offset(h, h.rings) <= (std::size_t)st.st_size;
+	if(ok)
+	{
+		const char* base = static_cast<const char*>(mem);
+		const std::uint32_t rings = std::min(h.rings, h.rings_used.load());
+		std::uint64_t overwritten = 0;
+		for(std::uint32_t i = 0; i < rings; ++i)
+		{
+			const ring_header& r = *reinterpret_cast<const ring_header*>(
+				base + ring_offset(h, i));
+			const std::uint64_t written = r.written.load();
+			overwritten += written > h.ring_events
+				? written - h.ring_events : 0;
+		}
+		std::fprintf(out, "{\"displayTimeUnit\": \"ns\", "
+			"\"otherData\": {\"pid\": %u, \"dropped\": %llu, "
+			"\"overwritten\": %llu}, \"traceEvents\": [\n", h.pid,
+			(unsigned long long)h.dropped.load(),
+			(unsigned long long)overwritten);
+
+		// the first instantiate() starts before the file exists
+		std::uint64_t origin = h.first_tick;
+		helpers::for_each_event(h, base, [&](const event& e) {
+			origin = std::min(origin, e.start); });
+
+		const char* separator = "";
+		helpers::for_each_event(h, base, [&](const event& e) {
+			std::fprintf(out, "%s{\"name\": \"%s\", \"cat\": \"%u\", "
+				"\"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, "
+				"\"pid\": %u, \"tid\": %u, \"args\": {\"unique_id\": %u, "
+				"\"instance\": %u, \"arg\": %u}}",
+				separator, name((event_type)e.type), e.unique_id,
+				(e.start - origin) / h.ticks_per_us,
+				e.duration / h.ticks_per_us, e.instance, e.thread,
+				e.unique_id, e.instance, e.arg);
+			separator = ",\n";
+		});
+		std::fprintf(out, "\n]}\n");
+	}
+	munmap(mem, st.st_size);
+	return ok;
+}
+
+}
+
+}
+
+#endif // LADSPAPP_TRACE_H
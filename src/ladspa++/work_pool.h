@@ -0,0 +1,230 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+
+#ifndef LADSPAPP_WORK_POOL_H
+#define LADSPAPP_WORK_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ladspa
+{
+
+/**
+ * @brief A small thread pool for parallel loops, for non-realtime use
+ *   only.
+ *
+ * Each parallel_for() takes one of a fixed number of job slots, and all
+ * threads take the indices of its loop from one atomic counter, so the
+ * threads balance the work without any queues. Nothing is allocated
+ * after construction, and no lock is taken while the loop runs. Only
+ * starting a loop wakes workers which sleep, which takes a mutex.
+ *
+ * If more loops run at once than there are slots, the extra loops run
+ * on their calling threads only.
+ * @note Waking workers may take a mutex, so never use the pool from a
+ *   realtime thread.
+ */
+class work_pool
+{
+	//! one parallel_for() call
+	struct job
+	{
+		void (*fn)(void* ctx, std::size_t index);
+		void* ctx;
+		std::size_t count;
+		std::atomic<std::size_t> next{0}; //!< the next index to run
+		std::atomic<std::size_t> done{0}; //!< indices which have run
+		std::atomic<bool> claimed{false}; //!< by a parallel_for() call
+		std::atomic<bool> published{false}; //!< workers may join
+		std::atomic<unsigned> users{0}; //!< workers inside the job
+
+		//! runs indices until there are none left
+		void work()
+		{
+			std::size_t i;
+			while((i = next.fetch_add(1, std::memory_order_relaxed))
+				< count)
+			{
+				fn(ctx, i);
+				done.fetch_add(1, std::memory_order_release);
+			}
+		}
+	};
+
+	static constexpr std::size_t max_jobs = 16;
+	//! workers spin this many times before they sleep
+	static constexpr unsigned spin_limit = 1024;
+
+	const unsigned _workers;
+	std::unique_ptr<job[]> _jobs;
+	std::vector<std::thread> _threads;
+	std::atomic<unsigned> _published{0}; //!< jobs workers may join
+	std::atomic<unsigned> _sleepers{0};
+	std::atomic<bool> _stop{false};
+	std::mutex _sleep_mutex;
+	std::condition_variable _wake;
+
+	//! joins published jobs, returns false if there were none
+	bool help(unsigned first)
+	{
+		bool found = false;
+		for(std::size_t k = 0; k < max_jobs; ++k)
+		{
+			job& j = _jobs[(first + k) % max_jobs];
+			if(!j.published.load(std::memory_order_relaxed))
+				continue;
+			// announce first, so the job stays valid while we are in
+			++j.users;
+			if(j.published)
+			{
+				found = true;
+				j.work();
+			}
+			--j.users;
+		}
+		return found;
+	}
+
+	void work(unsigned index)
+	{
+		for(unsigned spins = 0; !_stop; )
+		{
+			if(help(index))
+				spins = 0;
+			else if(++spins < spin_limit)
+				std::this_thread::yield();
+			else
+			{
+				std::unique_lock<std::mutex> lock(_sleep_mutex);
+				++_sleepers;
+				_wake.wait(lock, [this]() {
+					return _stop || _published > 0; });
+				--_sleepers;
+				spins = 0;
+			}
+		}
+	}
+
+public:
+	//! Starts @a workers threads, at least one
+	explicit work_pool(unsigned workers) : _workers(workers ? workers : 1),
+		_jobs(new job[max_jobs])
+	{
+		_threads.reserve(_workers);
+		for(unsigned i = 0; i < _workers; ++i)
+			_threads.emplace_back(&work_pool::work, this, i);
+	}
+
+	work_pool(const work_pool&) = delete;
+	work_pool& operator=(const work_pool&) = delete;
+
+	//! Joins the workers. No parallel_for() may be running.
+	~work_pool()
+	{
+		_stop = true;
+		{
+			std::lock_guard<std::mutex> lock(_sleep_mutex);
+		}
+		_wake.notify_all();
+		for(std::thread& t : _threads)
+			t.join();
+	}
+
+	//! Number of worker threads
+	unsigned workers() const { return _workers; }
+
+	//! Calls @a f(i) for each i in [0, @a n), on the workers and the
+	//! calling thread, and returns when all calls are done
+	template<class F>
+	void parallel_for(std::size_t n, F& f)
+	{
+		auto call = [](void* ctx, std::size_t index) {
+			(*static_cast<F*>(ctx))(index); };
+		job* j = nullptr;
+		for(std::size_t k = 0; k < max_jobs && !j; ++k)
+		{
+			bool expected = false;
+			if(_jobs[k].claimed.compare_exchange_strong(expected, true))
+				j = &_jobs[k];
+		}
+		if(!j)
+		{
+			for(std::size_t i = 0; i < n; ++i)
+				f(i);
+			return;
+		}
+
+		j->fn = call;
+		j->ctx = &f;
+		j->count = n;
+		j->next.store(0, std::memory_order_relaxed);
+		j->done.store(0, std::memory_order_relaxed);
+		// seq_cst, paired with the workers going to sleep
+		j->published = true;
+		++_published;
+		if(_sleepers)
+		{
+			std::lock_guard<std::mutex> lock(_sleep_mutex);
+			_wake.notify_all();
+		}
+
+		j->work();
+		while(j->done.load(std::memory_order_acquire) < n)
+			std::this_thread::yield();
+
+		// no worker may still read the job when it is reused
+		j->published = false;
+		--_published;
+		while(j->users)
+			std::this_thread::yield();
+		j->claimed.store(false, std::memory_order_release);
+	}
+
+	/**
+	 * @brief The process wide pool for offline rendering.
+	 *
+	 * Its size is read once, from the environment variable
+	 * LADSPAPP_THREADS, which counts the calling thread, too. If it is
+	 * unset or below 2, there is no pool, and this returns nullptr. So
+	 * realtime hosts never get a pool, unless the user asks for it.
+	 */
+	static work_pool* offline()
+	{
+		static const std::unique_ptr<work_pool> pool([]() {
+			const char* env = std::getenv("LADSPAPP_THREADS");
+			const unsigned long threads = env
+				? std::strtoul(env, nullptr, 10) : 0;
+			return (threads < 2) ? nullptr
+				: new work_pool((unsigned)threads - 1);
+		}());
+		return pool.get();
+	}
+};
+
+}
+
+#endif // LADSPAPP_WORK_POOL_H
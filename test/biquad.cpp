@@ -0,0 +1,195 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#include <complex>
+#include <cstdlib>
+#include <vector>
+
+#include "ladspa++/biquad.h"
+#include "test.h"
+
+using namespace ladspa;
+
+static constexpr double rate = 48000;
+
+//! the magnitude of the transfer function of @a c at @a freq, in dB
+static double gain_db(const biquad_coeffs& c, double freq)
+{
+	const std::complex<double> z1 = std::polar(1.0,
+		-2 * 3.14159265358979323846 * freq / rate);
+	const std::complex<double> z2 = z1 * z1;
+	const std::complex<double> h = ((double)c.b0 + (double)c.b1 * z1
+		+ (double)c.b2 * z2) / (1.0 + (double)c.a1 * z1
+		+ (double)c.a2 * z2);
+	return 20 * std::log10(std::abs(h));
+}
+
+static void check_designs()
+{
+	const double f = 1000, q = 0.707, nyquist = rate / 2;
+	const biquad_coeffs lp = biquad_coeffs::lowpass(f, q, rate);
+	CHECK_NEAR(gain_db(lp, 0), 0, 0.01);
+	CHECK_NEAR(gain_db(lp, f), -3.01, 0.05);
+	CHECK(gain_db(lp, 10 * f) < -35);
+
+	const biquad_coeffs hp = biquad_coeffs::highpass(f, q, rate);
+	CHECK_NEAR(gain_db(hp, nyquist * 0.999), 0, 0.01);
+	CHECK_NEAR(gain_db(hp, f), -3.01, 0.05);
+	CHECK(gain_db(hp, f / 10) < -35);
+
+	const biquad_coeffs bp = biquad_coeffs::bandpass(f, 2, rate);
+	CHECK_NEAR(gain_db(bp, f), 0, 0.01);
+	CHECK(gain_db(bp, f / 10) < -20 && gain_db(bp, 10 * f) < -20);
+
+	const biquad_coeffs notch = biquad_coeffs::notch(f, 2, rate);
+	CHECK(gain_db(notch, f) < -60);
+	CHECK_NEAR(gain_db(notch, 0), 0, 0.01);
+
+	const biquad_coeffs peak = biquad_coeffs::peaking(f, 1, 6, rate);
+	CHECK_NEAR(gain_db(peak, f), 6, 0.01);
+	CHECK_NEAR(gain_db(peak, 0), 0, 0.01);
+
+	const biquad_coeffs low = biquad_coeffs::low_shelf(f, 0.707, -9, rate);
+	CHECK_NEAR(gain_db(low, 0), -9, 0.01);
+	CHECK_NEAR(gain_db(low, nyquist * 0.999), 0, 0.05);
+
+	const biquad_coeffs high = biquad_coeffs::high_shelf(f, 0.707, 4, rate);
+	CHECK_NEAR(gain_db(high, 0), 0, 0.01);
+	CHECK_NEAR(gain_db(high, nyquist * 0.999), 4, 0.05);
+
+	CHECK(gain_db(biquad_coeffs::identity(), 1234) == 0);
+}
+
+static std::vector<data> noise(std::size_t n)
+{
+	std::vector<data> res(n);
+	for(data& x : res)
+		x = std::rand() / (data)RAND_MAX * 2 - 1;
+	return res;
+}
+
+static const biquad_coeffs designs[] = {
+	biquad_coeffs::lowpass(200, 0.707, rate),
+	biquad_coeffs::highpass(3000, 2, rate),
+	biquad_coeffs::peaking(1000, 4, 12, rate),
+	biquad_coeffs::notch(50, 10, rate)
+};
+
+//! a cascade must filter like its sections, one after the other, for any
+//! block size and in place
+template<std::size_t Sections>
+static void check_cascade()
+{
+	const std::vector<data> in = noise(1000);
+	std::vector<data> expected(in);
+	biquad_cascade<Sections> cascade;
+	for(std::size_t j = 0; j < Sections; ++j)
+	{
+		biquad single;
+		single.set(designs[j % 4]);
+		single.process(expected.data(), expected.data(), in.size());
+		cascade.set(j, designs[j % 4]);
+	}
+
+	std::vector<data> out(in);
+	// odd block sizes, so that the block formulation has remainders
+	for(std::size_t done = 0, n = 1; done < in.size(); done += n, n += 6)
+		cascade.process(out.data() + done, out.data() + done,
+			std::min(n, in.size() - done));
+	double err = 0;
+	for(std::size_t i = 0; i < in.size(); ++i)
+		err = std::max(err, (double)std::fabs(out[i] - expected[i]));
+	CHECK(err < 1e-4);
+}
+
+//! each band of a bank must filter like a single biquad
+static void check_bank()
+{
+	constexpr std::size_t bands = 4;
+	const std::vector<data> in = noise(777);
+	biquad_bank<bands> bank;
+	std::vector<data> out[bands], expected[bands];
+	data* outs[bands];
+	const data* ins[bands];
+	for(std::size_t b = 0; b < bands; ++b)
+	{
+		bank.set(b, designs[b]);
+		biquad single;
+		single.set(designs[b]);
+		expected[b].resize(in.size());
+		single.process(in.data(), expected[b].data(), in.size());
+		out[b] = in;
+		outs[b] = out[b].data();
+		ins[b] = out[b].data(); // in place
+	}
+	bank.process(ins, outs, in.size());
+	for(std::size_t b = 0; b < bands; ++b)
+	{
+		double err = 0;
+		for(std::size_t i = 0; i < in.size(); ++i)
+			err = std::max(err,
+				(double)std::fabs(out[b][i] - expected[b][i]));
+		CHECK(err < 1e-5);
+	}
+
+	// all bands filtering one input
+	bank.reset();
+	bank.process(in.data(), outs, in.size());
+	for(std::size_t b = 0; b < bands; ++b)
+		CHECK_NEAR(out[b][500], expected[b][500], 1e-5);
+}
+
+//! ramps must end exactly on the target coefficients
+static void check_ramps()
+{
+	const biquad_coeffs target = biquad_coeffs::lowpass(500, 1, rate);
+	std::vector<data> buf(64);
+
+	biquad_cascade<2> cascade;
+	cascade.set_smoothing(100);
+	cascade.set(0, target);
+	cascade.process(buf.data(), buf.data(), 64);
+	CHECK(cascade.coeffs(0) != target);
+	CHECK(cascade.coeffs(0) != biquad_coeffs::identity());
+	cascade.process(buf.data(), buf.data(), 64);
+	CHECK(cascade.coeffs(0) == target);
+	CHECK(cascade.coeffs(1) == biquad_coeffs::identity());
+
+	biquad_bank<2> bank;
+	bank.set_smoothing(100);
+	bank.set(1, target);
+	data* outs[2] = { buf.data(), buf.data() };
+	bank.process(buf.data(), outs, 64);
+	CHECK(bank.coeffs(1) != target);
+	bank.process(buf.data(), outs, 64);
+	CHECK(bank.coeffs(1) == target);
+	CHECK(bank.coeffs(0) == biquad_coeffs::identity());
+}
+
+int main()
+{
+	check_designs();
+	check_cascade<1>();
+	check_cascade<2>();
+	check_cascade<4>();
+	check_bank();
+	check_ramps();
+	return test::result("biquad");
+}
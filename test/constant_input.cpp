@@ -0,0 +1,141 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#include <limits>
+#include <vector>
+
+#include "ladspa++.h"
+#include "test.h"
+
+using namespace ladspa;
+
+//! each length, so that both the chunks of 32 and the rest are covered,
+//! and each position of a differing sample
+static void check_lengths()
+{
+	std::vector<data> x(100);
+	for(std::size_t n = 1; n <= x.size(); ++n)
+	{
+		x.assign(x.size(), 0.25f);
+		data value = 0;
+		CHECK(is_constant(const_buffer(x.data(), n), value)
+			&& value == 0.25f);
+		bool ok = true;
+		for(std::size_t i = 1; i < n; ++i)
+		{
+			x[i] = 0.5f;
+			ok = ok && !is_constant(const_buffer(x.data(), n), value);
+			x[i] = 0.25f;
+		}
+		CHECK(ok);
+	}
+}
+
+static void check_special()
+{
+	data value;
+	CHECK(!is_constant(const_buffer(nullptr, 0), value));
+
+	std::vector<data> x(40, std::numeric_limits<data>::quiet_NaN());
+	CHECK(!is_constant(const_buffer(x.data(), x.size()), value));
+	CHECK(!is_constant(const_buffer(x.data(), x.size()), value, 4));
+
+	// the exact check compares bits, the strided one compares floats
+	x.assign(40, 0.0f);
+	x[8] = -0.0f;
+	CHECK(!is_constant(const_buffer(x.data(), x.size()), value));
+	CHECK(is_constant(const_buffer(x.data(), x.size()), value, 4));
+
+	// a stride only compares every stride-th and the last sample
+	x.assign(40, 1.0f);
+	x[5] = 2;
+	CHECK(is_constant(const_buffer(x.data(), x.size()), value, 4));
+	x[39] = 2;
+	CHECK(!is_constant(const_buffer(x.data(), x.size()), value, 4));
+}
+
+//! writes 1 + value if the modulation input is constant, and -1 if not
+struct detector
+{
+	enum class port_names
+	{
+		mod,
+		out,
+		size
+	};
+
+	static constexpr port_info_t port_info[] =
+	{
+		port_info_common::audio_input,
+		port_info_common::audio_output,
+		port_info_common::final_port
+	};
+
+	static constexpr info_t info =
+	{
+		4700,
+		"test_detector",
+		properties::hard_rt_capable,
+		"Detector (constant input test)",
+		"Johannes Lorenz",
+		"Shows whether its input is constant.",
+		{"test"},
+		strings::copyright::gpl3,
+		nullptr
+	};
+
+	void run(port_array_t<port_names, port_info>& ports)
+	{
+		buffer out = ports.get<port_names::out>();
+		ports.dispatch_constant<port_names::mod>(
+			[&](data v) { out[0] = 1 + v; },
+			[&](const_buffer) { out[0] = -1; });
+	}
+};
+
+constexpr port_info_t detector::port_info[];
+constexpr info_t detector::info;
+
+//! only the samples of the current block count
+static void check_dispatch()
+{
+	const LADSPA_Descriptor* d
+		= collection<detector>::get_ladspa_descriptor(0);
+	LADSPA_Handle h = d->instantiate(d, 48000);
+	data mod[64], out[64];
+	d->connect_port(h, 0, mod);
+	d->connect_port(h, 1, out);
+	for(data& x : mod)
+		x = 3;
+	mod[40] = 4;
+	d->run(h, 40);
+	CHECK(out[0] == 4);
+	d->run(h, 41);
+	CHECK(out[0] == -1);
+	d->cleanup(h);
+}
+
+int main()
+{
+	check_lengths();
+	check_special();
+	check_dispatch();
+	return test::result("constant_input");
+}
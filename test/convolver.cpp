@@ -0,0 +1,98 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#include <cstdlib>
+#include <vector>
+
+#include "ladspa++/convolver.h"
+#include "test.h"
+
+using namespace ladspa;
+
+static std::vector<data> noise(std::size_t n)
+{
+	std::vector<data> res(n);
+	for(data& x : res)
+		x = std::rand() / (data)RAND_MAX * 2 - 1;
+	return res;
+}
+
+//! compares the convolver with a direct convolution, feeding it in
+//! chunks of varying sizes
+static void check(std::size_t ir_length, std::size_t block,
+	bool zero_latency)
+{
+	const std::vector<data> ir = noise(ir_length), in = noise(2000);
+	convolver conv;
+	conv.prepare(std::make_shared<const ir_spectra>(ir.data(), ir.size(),
+		block), zero_latency);
+	CHECK(conv.latency() == (zero_latency ? 0 : block));
+
+	std::vector<data> out(in);
+	for(std::size_t done = 0, n = 1; done < in.size(); done += n, n += 5)
+		conv.process(out.data() + done, out.data() + done,
+			std::min(n, in.size() - done));
+
+	double err = 0;
+	for(std::size_t i = 0; i < in.size(); ++i)
+	{
+		const std::size_t delayed = i - conv.latency();
+		double expected = 0;
+		for(std::size_t k = 0; i >= conv.latency() && k < ir.size()
+			&& k <= delayed; ++k)
+			expected += (double)ir[k] * in[delayed - k];
+		err = std::max(err, std::fabs(out[i] - expected));
+	}
+	if(!CHECK(err < 1e-4))
+		std::fprintf(stderr, "  ir length %zu, block %zu, zero latency "
+			"%d: error %g\n", ir_length, block, (int)zero_latency, err);
+}
+
+int main()
+{
+	for(bool zero_latency : { true, false })
+	{
+		check(1, 64, zero_latency);
+		check(20, 64, zero_latency); // shorter than one partition
+		check(64, 64, zero_latency);
+		check(300, 64, zero_latency);
+		check(1000, 128, zero_latency);
+		check(37, 2, zero_latency);
+	}
+
+	// unprepared convolvers output silence
+	convolver none;
+	data buf[3] = { 1, 1, 1 };
+	none.process(buf, buf, 3);
+	CHECK(buf[0] == 0 && buf[2] == 0);
+
+	// reset() forgets all past input
+	const std::vector<data> ir = noise(100), in = noise(256);
+	convolver conv;
+	conv.prepare(std::make_shared<const ir_spectra>(ir.data(), ir.size(),
+		32));
+	std::vector<data> first(in), second(in);
+	conv.process(first.data(), first.data(), first.size());
+	conv.reset();
+	conv.process(second.data(), second.data(), second.size());
+	CHECK(first == second);
+
+	return test::result("convolver");
+}
@@ -0,0 +1,98 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#include <vector>
+
+#include "ladspa++/delay_line.h"
+#include "test.h"
+
+using namespace ladspa;
+
+//! writes blocks of varying sizes, so that the write position wraps many
+//! times, and compares each delayed window with the plain history
+static void check_windows(delay_line& line)
+{
+	std::vector<data> history;
+	std::vector<data> block(line.max_block());
+	std::size_t n = 1;
+	for(int round = 0; round < 400; ++round)
+	{
+		n = (n * 7 + 3) % line.max_block() + 1;
+		for(std::size_t i = 0; i < n; ++i)
+			block[i] = history.size() + i + 1;
+		line.write(block.data(), n);
+		history.insert(history.end(), block.begin(), block.begin() + n);
+
+		for(std::size_t delay : { std::size_t(0), std::size_t(1),
+			line.max_delay() / 2, line.max_delay() })
+		{
+			const data* w = line.window(delay, n);
+			bool ok = true;
+			for(std::size_t k = 0; k < n; ++k)
+			{
+				const std::size_t idx = history.size() - n + k;
+				ok = ok && w[k] == (idx >= delay
+					? history[idx - delay] : 0);
+			}
+			CHECK(ok);
+			if(history.size() > delay)
+				CHECK(line.at(delay)
+					== history[history.size() - 1 - delay]);
+		}
+	}
+}
+
+//! process() must split blocks larger than max_block(), and work in place
+static void check_process(delay_line& line)
+{
+	const std::size_t delay = 100, n = 3 * line.max_block() + 17;
+	std::vector<data> signal(n), out(n);
+	for(std::size_t i = 0; i < n; ++i)
+		signal[i] = i + 1;
+	line.clear();
+	line.process(signal.data(), out.data(), n, delay);
+	bool ok = true;
+	for(std::size_t i = 0; i < n; ++i)
+		ok = ok && out[i] == (i >= delay ? signal[i - delay] : 0);
+	CHECK(ok);
+
+	line.clear();
+	std::vector<data> in_place(signal);
+	line.process(in_place.data(), in_place.data(), n, delay);
+	CHECK(in_place == out);
+}
+
+int main()
+{
+	delay_line line;
+	CHECK(line.allocate(1000, 64));
+	CHECK(line.max_delay() == 1000);
+	CHECK(line.max_block() >= 64);
+	check_windows(line);
+	check_process(line);
+
+	// an unallocated line outputs silence
+	delay_line empty;
+	data in[4] = { 1, 2, 3, 4 }, out[4] = { 1, 1, 1, 1 };
+	empty.process(in, out, 4, 0);
+	CHECK(out[0] == 0 && out[3] == 0);
+
+	return test::result("delay_line");
+}
@@ -0,0 +1,101 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "ladspa++/expression.h"
+#include "test.h"
+
+using namespace ladspa;
+
+static constexpr std::size_t n = 100;
+
+// the operators only exist for buffers and expressions, so code which
+// uses namespace ladspa still gets the usual ones for everything else
+static_assert(std::is_arithmetic<decltype(sqrt(1.0f))>::value, "");
+static_assert(std::is_arithmetic<decltype(tanh(1.0))>::value, "");
+static_assert(std::is_same<decltype(std::string() + std::string()),
+	std::string>::value, "");
+static_assert(helpers::is_signal<const_buffer>::value, "");
+static_assert(!helpers::is_signal<pointer>::value, "");
+static_assert(!helpers::is_binary_operand<pointer, float>::value, "");
+static_assert(!helpers::is_binary_operand<const_buffer, std::string>::value,
+	"");
+
+//! compares @a out with @a f(i) for each sample
+template<class F>
+static bool equals(const std::vector<data>& out, F f)
+{
+	bool ok = true;
+	for(std::size_t i = 0; i < n; ++i)
+		ok = ok && std::fabs(out[i] - f(i))
+			<= 1e-6f * (1 + std::fabs(f(i)));
+	return ok;
+}
+
+int main()
+{
+	std::vector<data> a(n), b(n), out(n);
+	for(std::size_t i = 0; i < n; ++i)
+	{
+		a[i] = std::rand() / (data)RAND_MAX * 2 - 1;
+		b[i] = std::rand() / (data)RAND_MAX * 2 - 1;
+	}
+	const_buffer in_a(a.data(), n), in_b(b.data(), n);
+	buffer res(out.data(), n);
+	data g1 = 0.5f, g2 = 0.25f;
+
+	res = in_a * g1 + in_b * g2;
+	CHECK(equals(out, [&](std::size_t i) { return a[i] * g1 + b[i] * g2; }));
+
+	res = 2.0f - in_a / 4 + -in_b;
+	CHECK(equals(out, [&](std::size_t i) { return 2 - a[i] / 4 - b[i]; }));
+
+	res = sqrt(abs(in_a)) + exp(in_b) * sin(in_a) - cos(in_b) / 3;
+	CHECK(equals(out, [&](std::size_t i) {
+		return std::sqrt(std::fabs(a[i])) + std::exp(b[i])
+			* std::sin(a[i]) - std::cos(b[i]) / 3; }));
+
+	out = a;
+	res += tanh(in_b) * 0.3f;
+	res -= in_a * in_b;
+	res *= 1 / (abs(in_a) + 1);
+	CHECK(equals(out, [&](std::size_t i) {
+		return (a[i] + std::tanh(b[i]) * 0.3f - a[i] * b[i])
+			/ (std::fabs(a[i]) + 1); }));
+
+	// control ports are read when the expression is built
+	pointer gain(&g1);
+	const auto scaled = in_a * gain;
+	g1 = 4;
+	res = scaled;
+	CHECK(equals(out, [&](std::size_t i) { return a[i] * 0.5f; }));
+
+	// in place
+	out = a;
+	res = res * 2 + 1;
+	CHECK(equals(out, [&](std::size_t i) { return a[i] * 2 + 1; }));
+
+	return test::result("expression");
+}
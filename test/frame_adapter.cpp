@@ -0,0 +1,126 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#include <cstdlib>
+#include <vector>
+
+#include "ladspa++/frame_adapter.h"
+#include "test.h"
+
+using namespace ladspa;
+
+static constexpr std::size_t length = 5000;
+
+static std::vector<data> noise(std::size_t n)
+{
+	std::vector<data> res(n);
+	for(data& x : res)
+		x = std::rand() / (data)RAND_MAX * 2 - 1;
+	return res;
+}
+
+/**
+ * Passes two channels through a frame adapter with a copying callback,
+ * in host blocks of size @a block (0 for varying sizes). The output must
+ * be the input, delayed by latency(). Without windows, each frame must
+ * also consist of the last Frame input samples.
+ */
+template<std::size_t Frame, std::size_t Hop>
+static void check(bool windowed, std::size_t block, bool in_place)
+{
+	typedef frame_adapter<Frame, Hop, 2> adapter_t;
+	adapter_t adapter(windowed);
+	const std::vector<data> in[2] = { noise(length), noise(length) };
+	std::vector<data> out[2] = { in[0], in[1] };
+	std::vector<data> tmp[2] = { in[0], in[1] };
+
+	std::size_t frames = 0;
+	bool frames_ok = true;
+	auto copy = [&](const data* const* x, data* const* y) {
+		const std::size_t end = ++frames * Hop;
+		for(std::size_t c = 0; c < 2; ++c)
+		for(std::size_t i = 0; i < Frame; ++i)
+		{
+			y[c][i] = x[c][i];
+			const std::size_t t = end - Frame + i;
+			if(!windowed)
+				frames_ok = frames_ok && x[c][i]
+					== (end + i >= Frame ? in[c][t] : 0);
+		}
+	};
+
+	for(std::size_t done = 0, n = 1; done < length; done += n)
+	{
+		n = std::min(block ? block : (n * 13 + 5) % 700 + 1,
+			length - done);
+		const data* src[2];
+		data* dest[2];
+		for(std::size_t c = 0; c < 2; ++c)
+		{
+			src[c] = (in_place ? out[c] : tmp[c]).data() + done;
+			dest[c] = out[c].data() + done;
+		}
+		adapter.process(src, dest, n, copy);
+	}
+
+	double err = 0;
+	for(std::size_t c = 0; c < 2; ++c)
+	for(std::size_t i = 0; i < length; ++i)
+	{
+		const data expected = i >= adapter_t::latency()
+			? in[c][i - adapter_t::latency()] : 0;
+		err = std::max(err, (double)std::fabs(out[c][i] - expected));
+	}
+	CHECK(frames == length / Hop);
+	CHECK(frames_ok);
+	if(!CHECK(err < 1e-5))
+		std::fprintf(stderr, "  frame %zu, hop %zu, windowed %d, block "
+			"%zu, in place %d: error %g\n", Frame, Hop, (int)windowed,
+			block, (int)in_place, err);
+}
+
+template<std::size_t Frame, std::size_t Hop>
+static void check_all(bool windowed)
+{
+	// small blocks, blocks larger than two frames, and varying sizes
+	for(std::size_t block : { std::size_t(1), std::size_t(Hop + 3),
+		std::size_t(1024), std::size_t(0) })
+	for(bool in_place : { false, true })
+		check<Frame, Hop>(windowed, block, in_place);
+}
+
+int main()
+{
+	check_all<64, 16>(true);
+	check_all<64, 16>(false);
+	check_all<32, 32>(false);
+	check_all<128, 64>(true);
+
+	// the mono version
+	frame_adapter<8, 8> mono;
+	data buf[20];
+	for(std::size_t i = 0; i < 20; ++i)
+		buf[i] = i + 1;
+	mono.process(buf, buf, 20, [](const data* x, data* y) {
+		std::copy(x, x + 8, y); });
+	CHECK(buf[6] == 0 && buf[7] == 1 && buf[19] == 13);
+
+	return test::result("frame_adapter");
+}
@@ -0,0 +1,207 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "ladspa++.h"
+#include "ladspa++/graph.h"
+#include "test.h"
+
+using namespace ladspa;
+
+static constexpr sample_size_t max_block = 64;
+
+//! out = in_1 * gain + in_2 + 1, where gain defaults to 0.5, so the
+//! results depend on the order of the inputs
+struct adder
+{
+	enum class port_names
+	{
+		gain,
+		in_1,
+		in_2,
+		out_1,
+		size
+	};
+
+	static constexpr port_info_t port_info[] =
+	{
+		{ "Gain", "Factor of the first input.",
+			port_types::input | port_types::control,
+			{(port_hints::bounded_below
+			| port_hints::bounded_above
+			| port_hints::default_maximum),
+			0, 0.5
+			} },
+		port_info_common::audio_input,
+		port_info_common::audio_input,
+		port_info_common::audio_output,
+		port_info_common::final_port
+	};
+
+	static constexpr info_t info =
+	{
+		4600,
+		"test_adder",
+		properties::hard_rt_capable,
+		"Adder (graph test)",
+		"Johannes Lorenz",
+		"Adds its inputs and 1.",
+		{"test"},
+		strings::copyright::gpl3,
+		nullptr
+	};
+
+	void run(port_array_t<port_names, port_info>& ports)
+	{
+		const data gain = ports.get<port_names::gain>();
+		const_buffer a = ports.get<port_names::in_1>();
+		const_buffer b = ports.get<port_names::in_2>();
+		buffer out = ports.get<port_names::out_1>();
+		for(std::size_t i = 0; i < out.size(); ++i)
+			out[i] = a[i] * gain + b[i] + 1;
+	}
+};
+
+constexpr port_info_t adder::port_info[];
+constexpr info_t adder::info;
+
+static const LADSPA_Descriptor* const d
+	= collection<adder>::get_ladspa_descriptor(0);
+
+/**
+ * Builds a random graph of @a nodes adders from @a seed, runs it with
+ * @a threads threads for 50 cycles of alternating sizes, and returns the
+ * graph outputs of all cycles.
+ */
+static std::vector<data> run_random(unsigned seed, unsigned threads,
+	std::size_t nodes)
+{
+	std::srand(seed);
+	graph g(48000, max_block, threads);
+	const std::size_t in = g.add_input();
+	std::vector<graph::node_id> ids;
+	for(std::size_t i = 0; i < nodes; ++i)
+		ids.push_back(g.add(d));
+	for(std::size_t i = 0; i < nodes; ++i)
+	for(port_size_t p = 1; p < 3; ++p)
+	{
+		// read the graph input, an earlier node, or nothing
+		const int r = std::rand() % (i + 2) - 1;
+		if(r < 0)
+			g.connect_input(in, ids[i], p);
+		else if((std::size_t)r < i && std::rand() % 3)
+			g.connect(ids[r], 3, ids[i], p);
+	}
+	std::vector<std::size_t> outs;
+	for(std::size_t i = 0; i < nodes; i += 7)
+		outs.push_back(g.add_output(ids[i], 3));
+	CHECK(g.compile());
+	CHECK(g.threads() == threads);
+
+	std::vector<data> res;
+	for(unsigned cycle = 0; cycle < 50; ++cycle)
+	{
+		const sample_size_t n = (cycle % 2) ? max_block : 33;
+		for(sample_size_t i = 0; i < n; ++i)
+			g.input(in)[i] = (data)(cycle * n + i) * 0.01f;
+		g.run(n);
+		for(std::size_t o : outs)
+			res.insert(res.end(), g.output(o), g.output(o) + n);
+	}
+	return res;
+}
+
+//! threads may only change the order in which independent nodes run,
+//! so the outputs must be the same, bit for bit
+static void check_parallel()
+{
+	for(unsigned seed = 0; seed < 20; ++seed)
+	{
+		const std::vector<data> serial = run_random(seed, 1, 200);
+		for(unsigned threads : { 2u, 4u })
+		{
+			const std::vector<data> parallel
+				= run_random(seed, threads, 200);
+			if(!CHECK(serial.size() == parallel.size()
+				&& !std::memcmp(serial.data(), parallel.data(),
+				serial.size() * sizeof(data))))
+				std::fprintf(stderr, "  seed %u, %u threads\n",
+					seed, threads);
+		}
+	}
+}
+
+//! a chain needs only two pooled buffers, and computes what it should
+static void check_chain()
+{
+	graph g(48000, max_block);
+	const std::size_t in = g.add_input();
+	graph::node_id prev = g.add(d);
+	g.connect_input(in, prev, 1);
+	for(int i = 1; i < 10; ++i)
+	{
+		const graph::node_id next = g.add(d);
+		CHECK(g.connect(prev, 3, next, 1));
+		prev = next;
+	}
+	g.set_control(prev, 0, 2);
+	const std::size_t out = g.add_output(prev, 3);
+	CHECK(g.compile());
+	CHECK(g.pooled_buffers() == 2);
+
+	for(sample_size_t i = 0; i < max_block; ++i)
+		g.input(in)[i] = (data)i;
+	g.run(max_block);
+	bool ok = true;
+	for(sample_size_t i = 0; i < max_block; ++i)
+	{
+		data expected = (data)i;
+		for(int k = 0; k < 9; ++k)
+			expected = expected * 0.5f + 1;
+		ok = ok && g.output(out)[i] == expected * 2 + 1;
+	}
+	CHECK(ok);
+}
+
+static void check_errors()
+{
+	graph g(48000, max_block);
+	const graph::node_id a = g.add(d), b = g.add(d);
+	CHECK(g.connect(a, 3, b, 1));
+	CHECK(!g.connect(a, 3, b, 1)); // already connected
+	CHECK(!g.connect(a, 1, b, 2)); // no output
+	CHECK(!g.connect(a, 3, b, 0)); // no audio input
+	CHECK(!g.connect_input(0, a, 1)); // no such graph input
+	CHECK(g.add_output(a, 3) == g.add_output(a, 3));
+	CHECK(g.add_output(a, 1) == graph::npos);
+	CHECK(g.connect(b, 3, a, 2));
+	CHECK(!g.compile()); // cycle
+}
+
+int main()
+{
+	check_parallel();
+	check_chain();
+	check_errors();
+	return test::result("graph");
+}
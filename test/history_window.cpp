@@ -0,0 +1,130 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#include <cstdlib>
+#include <vector>
+
+#include "ladspa++/history_window.h"
+#include "test.h"
+
+using namespace ladspa;
+
+static constexpr std::size_t length = 4000;
+
+static std::vector<data> noise(std::size_t n)
+{
+	std::vector<data> res(n);
+	for(data& x : res)
+		x = std::rand() / (data)RAND_MAX * 2 - 1;
+	return res;
+}
+
+/**
+ * Runs a FIR filter with @a Taps taps on two channels through a history
+ * window, in host blocks of size @a block (0 for varying sizes), and
+ * compares it with the filter run on the whole signal at once.
+ */
+template<std::size_t Taps>
+static void check(std::size_t block, bool in_place)
+{
+	const std::vector<data> h = noise(Taps);
+	const std::vector<data> in[2] = { noise(length), noise(length) };
+	std::vector<data> out[2] = { in[0], in[1] };
+	std::vector<data> tmp[2] = { in[0], in[1] };
+
+	history_window<Taps, 2> window;
+	auto fir = [&](const data* const* x, data* const* y, std::size_t n) {
+		for(std::size_t c = 0; c < 2; ++c)
+		{
+			for(std::size_t i = 0; i < n; ++i)
+				y[c][i] = h[0] * x[c][i];
+			for(std::size_t k = 1; k < Taps; ++k)
+			for(std::size_t i = 0; i < n; ++i)
+				y[c][i] += h[k] * x[c][i - k];
+		}
+	};
+	for(std::size_t done = 0, n = 1; done < length; done += n)
+	{
+		n = std::min(block ? block : (n * 11 + 7) % 600 + 1,
+			length - done);
+		const data* src[2];
+		data* dest[2];
+		for(std::size_t c = 0; c < 2; ++c)
+		{
+			src[c] = (in_place ? out[c] : tmp[c]).data() + done;
+			dest[c] = out[c].data() + done;
+		}
+		window.process(src, dest, n, fir);
+	}
+
+	double err = 0;
+	for(std::size_t c = 0; c < 2; ++c)
+	for(std::size_t i = 0; i < length; ++i)
+	{
+		data expected = h[0] * in[c][i];
+		for(std::size_t k = 1; k < Taps && k <= i; ++k)
+			expected += h[k] * in[c][i - k];
+		err = std::max(err, (double)std::fabs(out[c][i] - expected));
+	}
+	if(!CHECK(err < 1e-4))
+		std::fprintf(stderr, "  taps %zu, block %zu, in place %d: "
+			"error %g\n", Taps, block, (int)in_place, err);
+}
+
+template<std::size_t Taps>
+static void check_all()
+{
+	// blocks shorter than the history, equal to it, and much longer
+	for(std::size_t block : { std::size_t(1), std::size_t(Taps - 1),
+		std::size_t(Taps), std::size_t(1000), std::size_t(0) })
+	for(bool in_place : { false, true })
+		check<Taps>(block, in_place);
+}
+
+int main()
+{
+	check_all<2>();
+	check_all<32>();
+	check_all<300>(); // the history is longer than the in place chunks
+
+	// no history: the callback only gets the current samples
+	history_window<1> none;
+	data buf[3] = { 1, 2, 3 };
+	none.process(buf, buf, 3, [](const data* x, data* y, std::size_t n) {
+		for(std::size_t i = 0; i < n; ++i)
+			y[i] = 2 * x[i];
+	});
+	CHECK(buf[0] == 2 && buf[2] == 6);
+
+	// reset() forgets the tail
+	history_window<3> window;
+	data a[2] = { 5, 7 }, b[2] = { 0, 0 }, res[2];
+	auto sum = [](const data* x, data* y, std::size_t n) {
+		for(std::size_t i = 0; i < n; ++i)
+			y[i] = x[i] + x[i - 1] + x[i - 2];
+	};
+	window.process(a, res, 2, sum);
+	CHECK(res[0] == 5 && res[1] == 12);
+	window.reset();
+	window.process(b, res, 2, sum);
+	CHECK(res[0] == 0 && res[1] == 0);
+
+	return test::result("history_window");
+}
@@ -0,0 +1,167 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#include <cstdlib>
+#include <vector>
+
+#include "ladspa++/meter.h"
+#include "test.h"
+
+using namespace ladspa;
+
+static constexpr double pi = 3.14159265358979323846;
+
+//! the reductions must match plain loops for all lengths, including the
+//! remainders after the vectorized parts
+static void check_reductions()
+{
+	std::vector<data> x(40), y(40);
+	for(std::size_t i = 0; i < x.size(); ++i)
+	{
+		x[i] = std::rand() / (data)RAND_MAX * 2 - 1;
+		y[i] = std::rand() / (data)RAND_MAX * 2 - 1;
+	}
+	for(std::size_t n = 0; n <= x.size(); ++n)
+	{
+		double peak = 0, lo = n ? x[0] : 0, hi = lo, xy = 0, xx = 0;
+		for(std::size_t i = 0; i < n; ++i)
+		{
+			peak = std::max(peak, (double)std::fabs(x[i]));
+			lo = std::min(lo, (double)x[i]);
+			hi = std::max(hi, (double)x[i]);
+			xy += x[i] * y[i];
+			xx += x[i] * x[i];
+		}
+		data l, h;
+		min_max(x.data(), n, l, h);
+		CHECK(max_abs(x.data(), n) == (data)peak);
+		CHECK(l == (data)lo && h == (data)hi);
+		CHECK_NEAR(dot(x.data(), y.data(), n), xy, 1e-5);
+		CHECK_NEAR(sum_of_squares(x.data(), n), xx, 1e-5);
+	}
+}
+
+//! with decimation, the ballistics skip blocks, but the reductions must
+//! still see every sample
+static void check_decimation()
+{
+	std::vector<data> silence(64, 0), spike(64, 0);
+	spike[17] = -0.8f;
+
+	peak_meter peak(48000);
+	peak.set_decimation(4);
+	peak.process(silence.data(), 64);
+	peak.process(spike.data(), 64);
+	CHECK(peak.value() == 0); // the ballistics did not run yet
+	peak.process(silence.data(), 64);
+	peak.process(silence.data(), 64);
+	CHECK(peak.value() == 0.8f);
+
+	// the same energy, whether the ballistics run every block or not
+	rms_meter every(48000, 50), decimated(48000, 50);
+	decimated.set_decimation(8);
+	std::vector<data> sine(64);
+	for(std::size_t block = 0; block < 1000; ++block)
+	{
+		for(std::size_t i = 0; i < 64; ++i)
+			sine[i] = 0.5f * std::sin(2 * pi * 440
+				* (block * 64 + i) / 48000);
+		every.process(sine.data(), 64);
+		decimated.process(sine.data(), 64);
+	}
+	CHECK_NEAR(every.value(), 0.5 / std::sqrt(2.0), 1e-3);
+	CHECK_NEAR(decimated.value(), 0.5 / std::sqrt(2.0), 1e-3);
+
+	peak.reset();
+	CHECK(peak.value() == 0);
+}
+
+static void check_release()
+{
+	// one time constant after the peak, it fell to 1/e
+	peak_meter peak(1000, 100);
+	data one = 1, zero = 0;
+	peak.process(&one, 1);
+	CHECK(peak.value() == 1);
+	for(int i = 0; i < 100; ++i)
+		peak.process(&zero, 1);
+	CHECK_NEAR(peak.value(), std::exp(-1.0), 1e-4);
+}
+
+static void check_correlation()
+{
+	std::vector<data> l(4800), r(4800), silence(4800, 0);
+	for(std::size_t i = 0; i < l.size(); ++i)
+		l[i] = std::sin(2 * pi * 440 * i / 48000);
+
+	correlation_meter meter(48000);
+	for(std::size_t i = 0; i < l.size(); ++i)
+		r[i] = l[i];
+	meter.process(l.data(), r.data(), l.size());
+	CHECK_NEAR(meter.value(), 1, 1e-4);
+
+	meter.reset();
+	for(std::size_t i = 0; i < l.size(); ++i)
+		r[i] = -l[i];
+	meter.process(l.data(), r.data(), l.size());
+	CHECK_NEAR(meter.value(), -1, 1e-4);
+
+	// sine and cosine are unrelated
+	meter.reset();
+	for(std::size_t i = 0; i < l.size(); ++i)
+		r[i] = std::cos(2 * pi * 440 * i / 48000);
+	meter.process(l.data(), r.data(), l.size());
+	CHECK_NEAR(meter.value(), 0, 0.02);
+
+	meter.reset();
+	meter.process(silence.data(), silence.data(), silence.size());
+	CHECK(meter.value() == 1);
+}
+
+//! a 997 Hz sine with full scale peaks reads as -3.01 LUFS (BS.1770)
+static void check_loudness()
+{
+	for(double rate : { 44100.0, 48000.0, 96000.0 })
+	{
+		loudness_meter<1> meter(rate);
+		std::vector<data> sine((std::size_t)rate);
+		for(std::size_t i = 0; i < sine.size(); ++i)
+			sine[i] = std::sin(2 * pi * 997 * i / rate);
+		const data* in = sine.data();
+		meter.process(&in, sine.size());
+		CHECK_NEAR(meter.value(), -3.01, 0.05);
+	}
+
+	loudness_meter<2> stereo(48000);
+	std::vector<data> silence(48000, 0);
+	const data* in[2] = { silence.data(), silence.data() };
+	stereo.process(in, silence.size());
+	CHECK(stereo.value() <= -70);
+}
+
+int main()
+{
+	check_reductions();
+	check_decimation();
+	check_release();
+	check_correlation();
+	check_loudness();
+	return test::result("meter");
+}
@@ -0,0 +1,127 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#include <cmath>
+#include <vector>
+
+#include "ladspa++/oscillator.h"
+#include "test.h"
+
+using namespace ladspa;
+
+static constexpr double rate = 48000;
+static constexpr double pi = 3.14159265358979323846;
+
+//! the magnitude of @a x at @a freq, relative to a full scale sine
+static double magnitude(const std::vector<data>& x, double freq)
+{
+	double re = 0, im = 0;
+	for(std::size_t i = 0; i < x.size(); ++i)
+	{
+		re += x[i] * std::cos(2 * pi * freq * i / rate);
+		im += x[i] * std::sin(2 * pi * freq * i / rate);
+	}
+	return 2 * std::sqrt(re * re + im * im) / x.size();
+}
+
+static void check_sine()
+{
+	oscillator osc(waveform::sine, rate);
+	std::vector<data> out(1000);
+	osc.process(1000, out.data(), out.size());
+	double err = 0;
+	for(std::size_t i = 0; i < out.size(); ++i)
+		err = std::max(err, std::fabs(out[i]
+			- std::sin(2 * pi * 1000 * i / rate)));
+	CHECK(err < 1e-4);
+	CHECK_NEAR(osc.phase(), 1000 * 1000 / rate - 20, 1e-6);
+
+	// negative frequencies run backwards
+	osc.reset();
+	osc.process(-1000, out.data(), out.size());
+	CHECK_NEAR(out[3], -std::sin(2 * pi * 1000 * 3 / rate), 1e-4);
+
+	// reset() sets the phase in cycles
+	osc.reset(1.25);
+	osc.process(0, out.data(), 1);
+	CHECK_NEAR(out[0], 1, 1e-4);
+}
+
+//! a saw rises from -1 to 1, and its harmonics above the Nyquist
+//! frequency must not fold back
+static void check_saw()
+{
+	oscillator osc(waveform::saw, rate);
+	std::vector<data> out(4800);
+	osc.process(100, out.data(), out.size());
+	CHECK_NEAR(out[120], -0.5, 0.01); // a quarter cycle
+	CHECK_NEAR(out[360], 0.5, 0.01);
+
+	// 5 kHz has 4 harmonics below 24 kHz, 4800 samples are 500 cycles
+	osc.reset();
+	osc.process(5000, out.data(), out.size());
+	const double fundamental = magnitude(out, 5000);
+	CHECK_NEAR(fundamental, 2 / pi, 0.01);
+	CHECK_NEAR(magnitude(out, 10000), 1 / pi, 0.01);
+	for(double alias : { 3000.0, 8000.0, 13000.0, 18000.0, 23000.0 })
+		CHECK(magnitude(out, alias) < fundamental * 1e-3);
+}
+
+static void check_fm()
+{
+	oscillator plain(waveform::sine, rate), modulated(waveform::sine, rate);
+	std::vector<data> a(300), b(300), fm(300, 600);
+	// an unpatched FM input costs nothing and changes nothing
+	plain.process(1000, a.data(), a.size());
+	modulated.process(400, fm.data(), b.data(), b.size());
+	CHECK(a == b);
+
+	// through zero: the frequency is the sum
+	fm.assign(300, 1000);
+	fm[299] = 0;
+	plain.reset();
+	modulated.reset();
+	plain.process(1000, a.data(), a.size());
+	modulated.process(0, fm.data(), b.data(), b.size());
+	bool ok = true;
+	for(std::size_t i = 0; i < 300; ++i)
+		ok = ok && std::fabs(a[i] - b[i]) < 1e-5;
+	CHECK(ok);
+	CHECK(std::fabs(plain.phase() - modulated.phase()) > 1e-3);
+
+	// beyond the Nyquist frequency, the increment is clamped
+	modulated.process(1e9f, a.data(), a.size());
+	ok = true;
+	for(data x : a)
+		ok = ok && std::fabs(x) <= 1.0001f;
+	CHECK(ok);
+}
+
+int main()
+{
+	check_sine();
+	check_saw();
+	check_fm();
+
+	// all instances share the tables
+	CHECK(wavetable::get(waveform::square)
+		== wavetable::get(waveform::square));
+	return test::result("oscillator");
+}
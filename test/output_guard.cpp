@@ -0,0 +1,174 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#include <cstdlib>
+#include <limits>
+
+#include "ladspa++.h"
+#include "test.h"
+
+using namespace ladspa;
+
+static unsigned activations = 0, deactivations = 0;
+
+//! copies its input, so the test decides what the guard sees
+template<guard_mode Mode, unsigned ResetAfter>
+struct passthrough
+{
+	enum class port_names
+	{
+		in,
+		out,
+		size
+	};
+
+	static constexpr port_info_t port_info[] =
+	{
+		port_info_common::audio_input,
+		port_info_common::audio_output,
+		port_info_common::final_port
+	};
+
+	static constexpr info_t info =
+	{
+		4400,
+		"test_passthrough",
+		properties::hard_rt_capable,
+		"Passthrough (output guard test)",
+		"Johannes Lorenz",
+		"Copies the input.",
+		{"test"},
+		strings::copyright::gpl3,
+		nullptr
+	};
+
+	static constexpr output_guard_t output_guard = { Mode, ResetAfter };
+
+	void activate() { ++activations; }
+	void deactivate() { ++deactivations; }
+
+	void run(port_array_t<port_names, port_info>& ports)
+	{
+		const_buffer in = ports.template get<port_names::in>();
+		buffer out = ports.template get<port_names::out>();
+		for(std::size_t i = 0; i < out.size(); ++i)
+			out[i] = in[i];
+	}
+};
+
+template<guard_mode Mode, unsigned ResetAfter>
+constexpr port_info_t passthrough<Mode, ResetAfter>::port_info[];
+template<guard_mode Mode, unsigned ResetAfter>
+constexpr info_t passthrough<Mode, ResetAfter>::info;
+template<guard_mode Mode, unsigned ResetAfter>
+constexpr output_guard_t passthrough<Mode, ResetAfter>::output_guard;
+
+static const data not_a_number = std::numeric_limits<data>::quiet_NaN();
+static const data infinity = std::numeric_limits<data>::infinity();
+static const data denormal = std::numeric_limits<data>::denorm_min();
+
+//! an instance of @a P, connected to in and out
+template<class P>
+class instance
+{
+	const LADSPA_Descriptor* d = collection<P>::get_ladspa_descriptor(0);
+	LADSPA_Handle h = d->instantiate(d, 48000);
+public:
+	data in[4], out[4];
+	instance()
+	{
+		d->connect_port(h, 0, in);
+		d->connect_port(h, 1, out);
+	}
+	~instance() { d->cleanup(h); }
+	void run(data a, data b, data c, data e)
+	{
+		in[0] = a; in[1] = b; in[2] = c; in[3] = e;
+		d->run(h, 4);
+	}
+	guard_stats stats() const { return output_guard_stats<P>(h); }
+};
+
+static void check_zero()
+{
+	instance<passthrough<guard_mode::zero, 0>> p;
+	p.run(1, not_a_number, -infinity, denormal);
+	CHECK(p.out[0] == 1 && p.out[1] == 0 && p.out[2] == 0
+		&& p.out[3] == 0);
+	p.run(-denormal, 2, 3, 4);
+	CHECK(p.out[0] == 0 && p.out[3] == 4);
+	const guard_stats s = p.stats();
+	CHECK(s.faulty_blocks == 1 && s.bad_samples == 2);
+	CHECK(s.denormals == 2 && s.resets == 0);
+}
+
+static void check_hold()
+{
+	instance<passthrough<guard_mode::hold, 0>> p;
+	p.run(1, not_a_number, 2, infinity);
+	CHECK(p.out[0] == 1 && p.out[1] == 1 && p.out[2] == 2
+		&& p.out[3] == 2);
+	// the last sample of a clean block is held into the next one
+	p.run(5, 6, 7, 8);
+	p.run(not_a_number, not_a_number, 9, denormal);
+	CHECK(p.out[0] == 8 && p.out[1] == 8 && p.out[2] == 9
+		&& p.out[3] == 0);
+	CHECK(p.stats().faulty_blocks == 2 && p.stats().bad_samples == 4);
+}
+
+//! three faulty blocks in a row reset the plugin, clean blocks in
+//! between restart the count
+static void check_reset()
+{
+	instance<passthrough<guard_mode::zero, 3>> p;
+	activations = deactivations = 0;
+	p.run(not_a_number, 0, 0, 0);
+	p.run(not_a_number, 0, 0, 0);
+	p.run(1, 2, 3, 4);
+	p.run(not_a_number, 0, 0, 0);
+	p.run(not_a_number, 0, 0, 0);
+	CHECK(p.stats().resets == 0 && activations == 0);
+	p.run(not_a_number, 0, 0, 0);
+	CHECK(p.stats().resets == 1);
+	CHECK(activations == 1 && deactivations == 1);
+	// denormals alone are no faults
+	for(int i = 0; i < 3; ++i)
+		p.run(denormal, 0, 0, 0);
+	CHECK(p.stats().resets == 1 && p.stats().faulty_blocks == 5);
+	CHECK(p.stats().denormals == 3);
+}
+
+static void check_off()
+{
+	instance<passthrough<guard_mode::off, 3>> p;
+	p.run(not_a_number, infinity, denormal, 1);
+	CHECK(p.out[0] != p.out[0] && p.out[1] == infinity
+		&& p.out[2] == denormal);
+	CHECK(p.stats().faulty_blocks == 0 && p.stats().denormals == 0);
+}
+
+int main()
+{
+	check_zero();
+	check_hold();
+	check_reset();
+	check_off();
+	return test::result("output_guard");
+}
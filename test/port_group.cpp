@@ -0,0 +1,92 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "ladspa++.h"
+#include "test.h"
+
+using namespace ladspa;
+
+// the 8 channel mixer, from examples/mixer.cpp
+const LADSPA_Descriptor* ladspa_descriptor(plugin_index_t index);
+
+static constexpr port_size_t channels = 8;
+static constexpr std::size_t n = 100;
+
+//! a group expands to one ladspa port per channel, with numbered names
+static void check_ports(const LADSPA_Descriptor* d)
+{
+	CHECK(d->PortCount == 2 * channels + 1);
+	bool ok = true;
+	for(port_size_t c = 0; c < channels; ++c)
+	{
+		const std::string number = std::to_string(c + 1);
+		ok = ok && d->PortNames[c] == "Gain " + number
+			&& d->PortNames[channels + c] == "Input " + number
+			&& LADSPA_IS_PORT_CONTROL(d->PortDescriptors[c])
+			&& LADSPA_IS_PORT_AUDIO(d->PortDescriptors[channels + c])
+			&& LADSPA_IS_PORT_INPUT(d->PortDescriptors[channels + c]);
+	}
+	CHECK(ok);
+	CHECK(LADSPA_IS_PORT_OUTPUT(d->PortDescriptors[2 * channels]));
+}
+
+//! each channel must reach the output with its own gain, also if the
+//! output is one of the inputs
+static void check_mix(const LADSPA_Descriptor* d, bool in_place)
+{
+	LADSPA_Handle h = d->instantiate(d, 48000);
+	std::vector<data> in[channels], out(n);
+	data gains[channels];
+	for(port_size_t c = 0; c < channels; ++c)
+	{
+		gains[c] = c * 0.25f;
+		in[c].resize(n);
+		for(data& x : in[c])
+			x = std::rand() / (data)RAND_MAX * 2 - 1;
+		d->connect_port(h, c, gains + c);
+		d->connect_port(h, channels + c, in[c].data());
+	}
+	std::vector<data> expected(n, 0);
+	for(std::size_t i = 0; i < n; ++i)
+	{
+		expected[i] = in[0][i] * gains[0];
+		for(port_size_t c = 1; c < channels; ++c)
+			expected[i] += in[c][i] * gains[c];
+	}
+	// in place, the output is the last input (the first one has gain 0)
+	data* dest = in_place ? in[channels - 1].data() : out.data();
+	d->connect_port(h, 2 * channels, dest);
+	d->run(h, n);
+	CHECK(std::vector<data>(dest, dest + n) == expected);
+	d->cleanup(h);
+}
+
+int main()
+{
+	const LADSPA_Descriptor* d = ladspa_descriptor(0);
+	check_ports(d);
+	check_mix(d, false);
+	check_mix(d, true);
+	return test::result("port_group");
+}
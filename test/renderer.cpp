@@ -0,0 +1,122 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ladspa++.h"
+#include "ladspa++/renderer.h"
+#include "test.h"
+
+using namespace ladspa;
+
+// the amplifier, from examples/amplifier.cpp
+const LADSPA_Descriptor* ladspa_descriptor(plugin_index_t index);
+
+static constexpr std::size_t frames = 3000;
+
+//! runs render_main() with the amplifier linked in
+static int render(std::vector<std::string> args)
+{
+	args.insert(args.begin(), "test_renderer");
+	std::vector<char*> argv;
+	for(std::string& a : args)
+		argv.push_back(&a[0]);
+	argv.push_back(nullptr);
+	optind = 1;
+	return render_main(argv.size() - 1, argv.data(), ladspa_descriptor);
+}
+
+//! writes a stereo WAV file with a ramp on the left and its negation on
+//! the right channel
+static bool write_input(const std::string& path)
+{
+	std::vector<data> left(frames), right(frames);
+	for(std::size_t i = 0; i < frames; ++i)
+		right[i] = -(left[i] = (data)i / frames);
+	const data* channels[2] = { left.data(), right.data() };
+	audio_file_writer out;
+	return out.open(path.c_str(), 2, 44100, audio_file::float_32)
+		&& out.write(channels, frames) && out.close();
+}
+
+int main()
+{
+	char tmpl[] = "/tmp/ladspapp_test_XXXXXX";
+	const std::string dir = mkdtemp(tmpl) ? tmpl : "";
+	if(!CHECK(!dir.empty()))
+		return test::result("renderer");
+	const std::string a = dir + "/a", b = dir + "/b", out = dir + "/out";
+	for(const std::string& d : { a, b, out })
+		mkdir(d.c_str(), 0700);
+	CHECK(write_input(a + "/x.wav"));
+	CHECK(write_input(b + "/x.wav"));
+	CHECK(write_input(a + "/y.wav"));
+
+	// one instance per channel, two files at once
+	CHECK(render({ "-c", "Gain=0.5", "-j", "2", "-o", out,
+		a + "/x.wav", a + "/y.wav" }) == EXIT_SUCCESS);
+	for(const char* name : { "/x.wav", "/y.wav" })
+	{
+		audio_file result;
+		if(!CHECK(result.open((out + name).c_str())))
+			continue;
+		CHECK(result.channels() == 2 && result.frames() == frames);
+		CHECK(result.rate() == 44100);
+		std::vector<data> left(frames), right(frames);
+		data* channels[2] = { left.data(), right.data() };
+		result.read_frames(0, frames, channels);
+		bool ok = true;
+		for(std::size_t i = 0; i < frames; ++i)
+			ok = ok && left[i] == (data)i / frames * 0.5f
+				&& right[i] == -left[i];
+		CHECK(ok);
+	}
+
+	// rendering into the input's directory would overwrite the input
+	CHECK(render({ "-o", a, a + "/x.wav" }) == EXIT_FAILURE);
+	audio_file input;
+	CHECK(input.open((a + "/x.wav").c_str())
+		&& input.frames() == frames);
+	input.close();
+
+	// two inputs of the same name would be written to one output file.
+	// nothing may be rendered then, so y.wav keeps the gain of 0.5
+	CHECK(render({ "-o", out, a + "/y.wav", b + "/x.wav",
+		a + "/x.wav" }) == EXIT_FAILURE);
+	audio_file kept;
+	data last = 0;
+	if(CHECK(kept.open((out + "/y.wav").c_str())))
+		kept.read(0, frames - 1, 1, &last);
+	CHECK(last == (data)(frames - 1) / frames * 0.5f);
+
+	for(const std::string& d : { a, b, out })
+	{
+		for(const char* name : { "/x.wav", "/y.wav" })
+			std::remove((d + name).c_str());
+		rmdir(d.c_str());
+	}
+	rmdir(dir.c_str());
+	return test::result("renderer");
+}
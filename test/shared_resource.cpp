@@ -0,0 +1,78 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "ladspa++/shared_resource.h"
+#include "test.h"
+
+using namespace ladspa;
+
+static std::atomic<unsigned> constructed(0);
+
+//! counts how often it is built
+struct table
+{
+	unsigned long rate;
+	explicit table(unsigned long _rate) : rate(_rate) { ++constructed; }
+};
+
+struct other_plugin {};
+
+int main()
+{
+	typedef shared_resource<table> cache;
+	{
+		std::shared_ptr<const table> a = cache::get(44100),
+			b = cache::get(44100), c = cache::get(48000);
+		CHECK(a == b && a != c);
+		CHECK(a->rate == 44100 && c->rate == 48000);
+		CHECK(constructed == 2 && cache::size() == 2);
+
+		// another owner has a cache of its own
+		typedef shared_resource<table, unsigned long, other_plugin> other;
+		CHECK(other::get(44100) != a);
+		CHECK(constructed == 3);
+	}
+	// freed with the last holder, and built again when needed
+	CHECK(cache::size() == 0);
+	CHECK(cache::get(44100)->rate == 44100 && constructed == 4);
+
+	// failures are not cached
+	CHECK(!cache::get(1, []() { return (table*)nullptr; }));
+	CHECK(cache::get(1)->rate == 1);
+
+	// threads asking at once get the same object, built once
+	constructed = 0;
+	std::vector<std::shared_ptr<const table>> got(16);
+	std::vector<std::thread> threads;
+	for(std::size_t t = 0; t < got.size(); ++t)
+		threads.emplace_back([&got, t]() { got[t] = cache::get(96000); });
+	for(std::thread& t : threads)
+		t.join();
+	bool same = true;
+	for(const std::shared_ptr<const table>& p : got)
+		same = same && p == got[0];
+	CHECK(same && constructed == 1);
+
+	return test::result("shared_resource");
+}
@@ -0,0 +1,152 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "ladspa++.h"
+#include "ladspa++/stateless.h"
+#include "test.h"
+
+using namespace ladspa;
+
+//! each index must be run exactly once, also if more loops run at once
+//! than the pool has job slots
+static void check_pool()
+{
+	work_pool pool(3);
+	CHECK(pool.workers() == 3);
+
+	constexpr std::size_t n = 1000;
+	std::vector<std::atomic<unsigned>> runs(n);
+	auto count = [&](std::size_t i) { ++runs[i]; };
+	pool.parallel_for(n, count);
+	bool ok = true;
+	for(std::atomic<unsigned>& r : runs)
+		ok = ok && r == 1;
+	CHECK(ok);
+
+	constexpr unsigned callers = 24, loops = 20;
+	std::vector<std::atomic<unsigned>> totals(n);
+	auto add = [&](std::size_t i) { ++totals[i]; };
+	std::vector<std::thread> threads;
+	for(unsigned t = 0; t < callers; ++t)
+		threads.emplace_back([&]() {
+			for(unsigned l = 0; l < loops; ++l)
+				pool.parallel_for(n, add);
+		});
+	for(std::thread& t : threads)
+		t.join();
+	ok = true;
+	for(std::atomic<unsigned>& r : totals)
+		ok = ok && r == callers * loops;
+	CHECK(ok);
+}
+
+//! out = in * in * gain
+struct square
+{
+	enum class port_names
+	{
+		gain,
+		in,
+		out,
+		size
+	};
+
+	static constexpr port_info_t port_info[] =
+	{
+		{ "Gain", "Factor of the squared input.",
+			port_types::input | port_types::control,
+			{port_hints::default_1, 0} },
+		port_info_common::audio_input,
+		port_info_common::audio_output,
+		port_info_common::final_port
+	};
+
+	static constexpr info_t info =
+	{
+		4800,
+		"test_square",
+		properties::hard_rt_capable,
+		"Square (stateless test)",
+		"Johannes Lorenz",
+		"Squares the input.",
+		{"test"},
+		strings::copyright::gpl3,
+		nullptr
+	};
+
+	static constexpr bool stateless = true;
+
+	void run(port_array_t<port_names, port_info>& ports)
+	{
+		const data gain = ports.get<port_names::gain>();
+		const_buffer in = ports.get<port_names::in>();
+		buffer out = ports.get<port_names::out>();
+		for(std::size_t i = 0; i < out.size(); ++i)
+			out[i] = in[i] * in[i] * gain;
+	}
+};
+
+constexpr port_info_t square::port_info[];
+constexpr info_t square::info;
+
+//! blocks split into chunks must give the same result as one run()
+static void check_chunks()
+{
+	CHECK(work_pool::offline() != nullptr);
+	const LADSPA_Descriptor* d
+		= collection<square>::get_ladspa_descriptor(0);
+	LADSPA_Handle h = d->instantiate(d, 48000);
+	data gain = 3;
+	for(std::size_t n : { std::size_t(100), 2 * stateless_min_chunk,
+		3 * stateless_min_chunk + 5, 40 * stateless_min_chunk + 1 })
+	for(bool in_place : { false, true })
+	{
+		std::vector<data> in(n), out(n);
+		for(data& x : in)
+			x = std::rand() / (data)RAND_MAX * 2 - 1;
+		const std::vector<data> orig(in);
+		d->connect_port(h, 0, &gain);
+		d->connect_port(h, 1, in.data());
+		d->connect_port(h, 2, in_place ? in.data() : out.data());
+		d->run(h, n);
+		const std::vector<data>& res = in_place ? in : out;
+		bool ok = true;
+		for(std::size_t i = 0; i < n; ++i)
+			ok = ok && res[i] == orig[i] * orig[i] * gain;
+		if(!CHECK(ok))
+			std::fprintf(stderr, "  %zu samples, in place %d\n", n,
+				(int)in_place);
+	}
+	d->cleanup(h);
+}
+
+int main()
+{
+	// before anything asks for the offline pool
+	setenv("LADSPAPP_THREADS", "4", 1);
+	check_pool();
+	check_chunks();
+	return test::result("stateless");
+}
@@ -0,0 +1,76 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#ifndef LADSPAPP_TEST_H
+#define LADSPAPP_TEST_H
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+//! A minimal test harness, only used by the tests
+namespace test
+{
+
+//! the number of failed checks in this program
+inline int& failures()
+{
+	static int count = 0;
+	return count;
+}
+
+//! Counts and prints a failed check, returns @a ok
+inline bool check(bool ok, const char* what, const char* file, int line)
+{
+	if(!ok)
+	{
+		std::fprintf(stderr, "%s:%d: check failed: %s\n",
+			file, line, what);
+		++failures();
+	}
+	return ok;
+}
+
+//! Like check(), but prints both values if they differ by more than @a tol
+inline bool check_near(double a, double b, double tol, const char* what,
+	const char* file, int line)
+{
+	const bool ok = std::fabs(a - b) <= tol;
+	if(!ok)
+		std::fprintf(stderr, "%s:%d: %g and %g differ by more than %g\n",
+			file, line, a, b, tol);
+	return check(ok, what, file, line);
+}
+
+//! The return value for main(), after printing a summary
+inline int result(const char* name)
+{
+	if(failures())
+		std::fprintf(stderr, "%s: %d checks failed\n", name, failures());
+	return failures() ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+}
+
+#define CHECK(expr) test::check((expr), #expr, __FILE__, __LINE__)
+#define CHECK_NEAR(a, b, tol) test::check_near((a), (b), (tol), \
+	#a " ~ " #b, __FILE__, __LINE__)
+
+#endif // LADSPAPP_TEST_H
@@ -0,0 +1,193 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+#include "ladspa++.h"
+#include "test.h"
+
+using namespace ladspa;
+
+static constexpr std::size_t fade = 100;
+
+//! run<V>() multiplies the input by V + 1
+template<sample_size_t Crossfade>
+struct scaler
+{
+	enum class port_names
+	{
+		factor,
+		in,
+		out,
+		size
+	};
+
+	static constexpr port_info_t port_info[] =
+	{
+		{ "Factor", "The factor minus one.",
+			port_types::input | port_types::control,
+			{(port_hints::bounded_below
+			| port_hints::bounded_above
+			| port_hints::integer
+			| port_hints::default_minimum),
+			0, 3
+			} },
+		port_info_common::audio_input,
+		port_info_common::audio_output,
+		port_info_common::final_port
+	};
+
+	static constexpr info_t info =
+	{
+		4500 + Crossfade,
+		"test_scaler",
+		properties::hard_rt_capable,
+		"Scaler (variant test)",
+		"Johannes Lorenz",
+		"Multiplies the input by the factor.",
+		{"test"},
+		strings::copyright::gpl3,
+		nullptr
+	};
+
+	static constexpr variant_port_t<port_names> variant_port
+		= { port_names::factor, Crossfade };
+
+	template<int V>
+	void run(port_array_t<port_names, port_info>& ports)
+	{
+		const_buffer in = ports.template get<port_names::in>();
+		buffer out = ports.template get<port_names::out>();
+		for(std::size_t i = 0; i < out.size(); ++i)
+			out[i] = in[i] * (V + 1);
+	}
+};
+
+template<sample_size_t Crossfade>
+constexpr port_info_t scaler<Crossfade>::port_info[];
+template<sample_size_t Crossfade>
+constexpr info_t scaler<Crossfade>::info;
+template<sample_size_t Crossfade>
+constexpr variant_port_t<typename scaler<Crossfade>::port_names>
+	scaler<Crossfade>::variant_port;
+
+//! runs an instance block by block, and records all outputs
+template<sample_size_t Crossfade>
+class instance
+{
+	const LADSPA_Descriptor* d
+		= collection<scaler<Crossfade>>::get_ladspa_descriptor(0);
+	LADSPA_Handle h = d->instantiate(d, 48000);
+	bool in_place;
+	std::vector<data> in, out;
+public:
+	data factor = 0;
+	std::vector<data> inputs, outputs;
+
+	instance(bool _in_place = false) : in_place(_in_place)
+	{
+		d->connect_port(h, 0, &factor);
+	}
+	~instance() { d->cleanup(h); }
+
+	void run(std::size_t n)
+	{
+		in.resize(n);
+		out.resize(n);
+		for(data& x : in)
+			x = std::rand() / (data)RAND_MAX + 0.5f;
+		inputs.insert(inputs.end(), in.begin(), in.end());
+		d->connect_port(h, 1, in.data());
+		d->connect_port(h, 2, in_place ? in.data() : out.data());
+		d->run(h, n);
+		const std::vector<data>& res = in_place ? in : out;
+		outputs.insert(outputs.end(), res.begin(), res.end());
+	}
+
+	//! the output at sample @a i divided by the input
+	data gain(std::size_t i) const { return outputs[i] / inputs[i]; }
+};
+
+//! a change fades linearly over the crossfade time, across blocks
+static void check_fade(bool in_place)
+{
+	instance<fade> p(in_place);
+	p.factor = 2;
+	p.run(32); // the first block does not fade
+	CHECK_NEAR(p.gain(0), 3, 1e-5);
+	p.factor = 0;
+	for(int i = 0; i < 5; ++i)
+		p.run(32);
+	bool ok = true;
+	for(std::size_t j = 0; j < 160; ++j)
+	{
+		const double t = std::min(1.0, (j + 1.0) / fade);
+		ok = ok && std::fabs(p.gain(32 + j) - (3 + (1 - 3) * t)) < 1e-5;
+	}
+	CHECK(ok);
+}
+
+//! a new selection during a fade waits until the fade is done, so the
+//! gain never jumps
+static void check_interrupted()
+{
+	instance<fade> p;
+	p.run(10);
+	p.factor = 3;
+	p.run(30);
+	p.factor = 1;
+	for(int i = 0; i < 10; ++i)
+		p.run(25);
+	double max_step = 0;
+	for(std::size_t i = 1; i < p.outputs.size(); ++i)
+		max_step = std::max(max_step,
+			(double)std::fabs(p.gain(i) - p.gain(i - 1)));
+	CHECK(max_step <= 3.0 / fade + 1e-5);
+	CHECK_NEAR(p.gain(10 + fade - 1), 4, 1e-5);
+	CHECK_NEAR(p.gain(10 + 2 * fade - 1), 2, 1e-5);
+	CHECK_NEAR(p.gain(p.outputs.size() - 1), 2, 1e-5);
+}
+
+//! port values are rounded and clamped, and switch at once without fade
+static void check_select()
+{
+	instance<0> p;
+	const data values[] = { 1.4f, 1.6f, 7, -3, 2,
+		std::numeric_limits<data>::quiet_NaN() };
+	const data gains[] = { 2, 3, 4, 1, 3, 1 };
+	for(std::size_t i = 0; i < 6; ++i)
+	{
+		p.factor = values[i];
+		p.run(8);
+		CHECK_NEAR(p.gain(8 * i), gains[i], 1e-5);
+	}
+}
+
+int main()
+{
+	check_fade(false);
+	check_fade(true);
+	check_interrupted();
+	check_select();
+	return test::result("variants");
+}
@@ -0,0 +1,51 @@
+/*************************************************************************/
+/* ladspa++ - A C++ wrapper for ladspa                                   */
+/* Copyright (C) 2014-2018                                               */
+/* Johannes Lorenz                                                       */
+/* https://github.com/JohannesLorenz/                                    */
+/*                                                                       */
+/* This program is free software; you can redistribute it and/or modify  */
+/* it under the terms of the GNU General Public License as published by  */
+/* the Free Software Foundation; either version 3 of the License, or (at */
+/* your option) any later version.                                       */
+/* This program is distributed in the hope that it will be useful, but   */
+/* WITHOUT ANY WARRANTY; without even the implied warranty of            */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU      */
+/* General Public License for more details.                              */
+/*                                                                       */
+/* You should have received a copy of the GNU General Public License     */
+/* along with this program; if not, write to the Free Software           */
+/* Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA  */
+/*************************************************************************/
+
+/*
+ * Converts a trace file (see ladspa++/trace.h) to Chrome's trace format:
+ *   ladspa_trace /tmp/ladspa++-1234.trace > trace.json
+ */
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "ladspa++/trace.h"
+
+int main(int argc, char** argv)
+{
+	if(argc < 2 || argc > 3)
+	{
+		std::fprintf(stderr, "usage: %s <trace file> [<json file>]\n",
+			argv[0]);
+		return EXIT_FAILURE;
+	}
+	std::FILE* out = (argc == 3) ? std::fopen(argv[2], "w") : stdout;
+	if(!out)
+	{
+		std::perror(argv[2]);
+		return EXIT_FAILURE;
+	}
+	const bool ok = ladspa::trace::write_chrome_json(argv[1], out);
+	if(!ok)
+		std::fprintf(stderr, "%s: not a valid trace file\n", argv[1]);
+	if(out != stdout && std::fclose(out))
+		return EXIT_FAILURE;
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}